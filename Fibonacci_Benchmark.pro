@@ -0,0 +1,51 @@
+# Headless pipeline benchmark: build, layout, draw, reveal and render over standard sweeps.
+# Run with --out DIR to write CSVs and --baseline-dir DIR to fail on regressions.
+QT       += core gui widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = fibonacci_benchmark
+# heap counters in the results (replaces the global operator new, see allocstats.h)
+DEFINES += ALLOCSTATS_COUNTING
+
+SOURCES += \
+    allocstats.cpp \
+    benchmark.cpp \
+    bigint.cpp \
+    calltracer.cpp \
+    calltree.cpp \
+    fibvalues.cpp \
+    headless.cpp \
+    implicittree.cpp \
+    implicittreeview.cpp \
+    nodeitem.cpp \
+    nodelabels.cpp \
+    profiler.cpp \
+    revealtimeline.cpp \
+    tilecache.cpp \
+    treepainteritem.cpp \
+    treescene.cpp \
+    virtualscene.cpp
+
+HEADERS += \
+    allocstats.h \
+    bigint.h \
+    calltracer.h \
+    calltree.h \
+    fibvalues.h \
+    headless.h \
+    implicittree.h \
+    implicittreeview.h \
+    memodag.h \
+    nodeitem.h \
+    nodelabels.h \
+    profiler.h \
+    recurrence.h \
+    revealtimeline.h \
+    tilecache.h \
+    treepainteritem.h \
+    treescene.h \
+    virtualscene.h
+
+win32: LIBS += -lpsapi
@@ -9,15 +9,75 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    algobench.cpp \
+    algobenchpanel.cpp \
+    allocstats.cpp \
+    bigint.cpp \
+    calltracer.cpp \
+    calltree.cpp \
+    fibvalues.cpp \
+    headless.cpp \
+    implicittree.cpp \
+    implicittreeview.cpp \
+    logplot.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    memodag.cpp \
+    minimap.cpp \
+    nodeindex.cpp \
+    nodeitem.cpp \
+    nodelabels.cpp \
+    profiler.cpp \
+    resourcegovernor.cpp \
+    revealanimator.cpp \
+    revealtimeline.cpp \
+    subtreestore.cpp \
+    tilecache.cpp \
+    treebuilder.cpp \
+    treeexport.cpp \
+    treefile.cpp \
+    treepainteritem.cpp \
+    treescene.cpp \
+    virtualscene.cpp
 
 HEADERS += \
-    mainwindow.h
+    algobench.h \
+    algobenchpanel.h \
+    allocstats.h \
+    bigint.h \
+    calltracer.h \
+    calltree.h \
+    fibvalues.h \
+    headless.h \
+    implicittree.h \
+    implicittreeview.h \
+    logplot.h \
+    mainwindow.h \
+    memodag.h \
+    minimap.h \
+    nodeindex.h \
+    nodeitem.h \
+    nodelabels.h \
+    profiler.h \
+    recurrence.h \
+    resourcegovernor.h \
+    revealanimator.h \
+    revealtimeline.h \
+    subtreestore.h \
+    tilecache.h \
+    treebuilder.h \
+    treeexport.h \
+    treefile.h \
+    treepainteritem.h \
+    treescene.h \
+    virtualscene.h
 
 FORMS += \
     mainwindow.ui
 
+# peak RSS for the headless benchmark (GetProcessMemoryInfo)
+win32: LIBS += -lpsapi
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,207 @@
+#include "algobench.h"
+#include "bigint.h"
+#include "calltree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// F(92) is the last value that fits a machine word; the naive tree is far too big long before
+static const int MAX_NAIVE_N = 40;
+// recursion depth of the memoized run, on the worker thread's stack
+static const int MAX_MEMO_N = 5000;
+// stack per memoized call: about 72 bytes optimized, allowed several times that for debug
+// builds, plus room for the rest of the worker
+static const size_t MEMO_FRAME_BYTES = 512;
+static const size_t STACK_SLACK_BYTES = 1 << 20;
+// one run of the linear loop, the matrix power or fast doubling at these n takes about 0.5, 0.45
+// and 1.2 s on a 2020s desktop core; the loop grows as n^2, the others about as n^1.6
+static const int MAX_LOOP_N = 300000;
+static const int MAX_MATRIX_N = 3000000;
+static const int MAX_DOUBLING_N = 10000000;
+// growth of one run with n, used to predict the next point from the last one: the naive
+// recursion by the golden ratio per step, the others by a power of n (n additions of n-bit
+// numbers; Karatsuba products of n-bit numbers)
+static const double NAIVE_GROWTH = 1.618;
+static const double GROWTH_EXPONENT[BenchAlgorithmCount] = {0.0, 2.0, 2.0, 1.585, 1.585};
+// a sample repeats fast runs until it lasts at least this long
+static const double MIN_SAMPLE_NS = 50000.0;
+static const int MAX_BATCH = 1 << 20;
+// slow points get fewer samples (but at least MIN_SLOW_SAMPLES) to stay near this budget,
+// and an algorithm whose runs no longer fit it is not run for larger n
+static const double POINT_BUDGET_NS = 3e9;
+static const int MIN_SLOW_SAMPLES = 3;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t naiveFib(int k);
+// calls through a volatile pointer, so the compiler cannot fold the recursion into a loop
+uint64_t (*volatile naiveCall)(int) = naiveFib;
+
+uint64_t naiveFib(int k) {
+    return k < 2 ? uint64_t(k) : naiveCall(k - 1) + naiveCall(k - 2);
+}
+
+const BigUInt& memoFib(int k, std::vector<BigUInt>& memo, std::vector<std::uint8_t>& known) {
+    if (!known[k]) {
+        memo[k] = k < 2 ? BigUInt(uint64_t(k)) : memoFib(k - 1, memo, known) + memoFib(k - 2, memo, known);
+        known[k] = 1;
+    }
+    return memo[k];
+}
+
+// one full computation of F(n); the low word keeps the optimizer from dropping it. The
+// recursions are not interrupted: their runs stay short below MAX_NAIVE_N and MAX_MEMO_N.
+uint64_t runOnce(BenchAlgorithm algorithm, int n, const std::atomic<bool>& cancel) {
+    switch (algorithm) {
+    case BenchNaive: return naiveFib(n);
+    case BenchMemo: {
+        std::vector<BigUInt> memo(size_t(n) + 1);
+        std::vector<std::uint8_t> known(size_t(n) + 1, 0);
+        return memoFib(n, memo, known).toU64();
+    }
+    case BenchLoop: return fibLinear(uint64_t(n), &cancel).toU64();
+    case BenchMatrix: return fibMatrix(uint64_t(n), &cancel).toU64();
+    default: return fibFastDoubling(uint64_t(n), &cancel).toU64();
+    }
+}
+
+// a cancelled batch returns early; its time is not a sample
+double timeBatch(BenchAlgorithm algorithm, int n, int batch, const std::atomic<bool>& cancel) {
+    static volatile uint64_t sink = 0;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < batch && !cancel.load(std::memory_order_relaxed); ++i) sink = sink + runOnce(algorithm, n, cancel);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// time of one run at n from the last measured one at `from`
+double predictNs(BenchAlgorithm algorithm, int from, double fromNs, int n) {
+    if (algorithm == BenchNaive) return fromNs * std::pow(NAIVE_GROWTH, n - from);
+    return fromNs * std::pow(double(n) / from, GROWTH_EXPONENT[algorithm]);
+}
+
+int bitLength(int n) {
+    int bits = 0;
+    for (; n > 0; n >>= 1) ++bits;
+    return bits;
+}
+
+int popCount(int n) {
+    int ones = 0;
+    for (; n > 0; n >>= 1) ones += n & 1;
+    return ones;
+}
+
+// nearest rank on sorted samples
+double percentile(const std::vector<double>& sorted, double q) {
+    return sorted[size_t(std::lround(q * double(sorted.size() - 1)))];
+}
+
+} // namespace
+
+const char* AlgoBench::algorithmName(BenchAlgorithm algorithm) {
+    switch (algorithm) {
+    case BenchNaive: return "Naive recursion";
+    case BenchMemo: return "Memoized recursion";
+    case BenchLoop: return "DP loop";
+    case BenchMatrix: return "Matrix power";
+    default: return "Fast doubling";
+    }
+}
+
+int AlgoBench::maxN(BenchAlgorithm algorithm) {
+    if (algorithm == BenchNaive) return MAX_NAIVE_N;
+    if (algorithm == BenchMemo) return MAX_MEMO_N;
+    if (algorithm == BenchLoop) return MAX_LOOP_N;
+    if (algorithm == BenchMatrix) return MAX_MATRIX_N;
+    return MAX_DOUBLING_N;
+}
+
+size_t AlgoBench::stackBytes() {
+    return size_t(MAX_MEMO_N) * MEMO_FRAME_BYTES + STACK_SLACK_BYTES;
+}
+
+uint64_t AlgoBench::callCount(BenchAlgorithm algorithm, int n) {
+    switch (algorithm) {
+    case BenchNaive: return CallTree::naiveNodeCount(n);
+    case BenchMemo: return CallTree::memoNodeCount(n);
+    case BenchLoop: return uint64_t(n);
+    case BenchMatrix: return n == 0 ? 0 : uint64_t(bitLength(n) - 1 + popCount(n)); // squarings and products
+    default: return uint64_t(bitLength(n));
+    }
+}
+
+std::vector<int> AlgoBench::nValues(const BenchConfig& config) {
+    const int first = std::max(0, std::min(config.nFirst, config.nLast));
+    const int last = std::max(config.nFirst, config.nLast);
+    const int points = std::max(1, config.points);
+    std::vector<int> values;
+    // geometric from max(first, 1), so log scales space the points evenly
+    const double low = std::max(1, first), ratio = points > 1 ? std::pow(last / low, 1.0 / (points - 1)) : 1.0;
+    if (first == 0) values.push_back(0);
+    for (int i = 0; i < points; ++i) {
+        const int n = std::min(last, int(std::lround(low * std::pow(ratio, i))));
+        if (values.empty() || n > values.back()) values.push_back(n);
+    }
+    return values;
+}
+
+void AlgoBench::run(const BenchConfig& config, const std::atomic<bool>& cancel,
+                    const std::function<void(const BenchResult&)>& report) {
+    bool stopped[BenchAlgorithmCount] = {};
+    int lastN[BenchAlgorithmCount] = {};
+    double lastOnce[BenchAlgorithmCount] = {};
+    for (int n : nValues(config)) {
+        for (int a = 0; a < BenchAlgorithmCount; ++a) {
+            const BenchAlgorithm algorithm = BenchAlgorithm(a);
+            if (!config.algorithms[a] || stopped[a] || n > maxN(algorithm)) continue;
+            if (cancel.load(std::memory_order_relaxed)) return;
+            // points are spaced geometrically, so the next one may be far slower than the last
+            if (lastN[a] > 0 && predictNs(algorithm, lastN[a], lastOnce[a], n) * MIN_SLOW_SAMPLES > POINT_BUDGET_NS) {
+                stopped[a] = true;
+                continue;
+            }
+
+            // the first warm-up run also sizes the batch
+            const double once = timeBatch(algorithm, n, 1, cancel);
+            if (cancel.load(std::memory_order_relaxed)) return;
+            const int batch = int(std::clamp(std::ceil(MIN_SAMPLE_NS / std::max(1.0, once)), 1.0, double(MAX_BATCH)));
+            int warmups = config.warmup - 1;
+            int repetitions = std::max(1, config.repetitions);
+            if (once * (warmups + repetitions) > POINT_BUDGET_NS) {
+                warmups = 0;
+                repetitions = std::min(repetitions, std::max(MIN_SLOW_SAMPLES, int(POINT_BUDGET_NS / once)));
+            }
+            if (once * MIN_SLOW_SAMPLES > POINT_BUDGET_NS) stopped[a] = true;
+            for (int w = 0; w < warmups; ++w) timeBatch(algorithm, n, batch, cancel);
+
+            std::vector<double> samples;
+            samples.reserve(size_t(repetitions));
+            for (int r = 0; r < repetitions && !cancel.load(std::memory_order_relaxed); ++r) {
+                samples.push_back(timeBatch(algorithm, n, batch, cancel) / batch);
+            }
+            if (cancel.load(std::memory_order_relaxed)) return;
+            std::sort(samples.begin(), samples.end());
+            // the batched median, not the single cold run, is what the next prediction scales
+            lastN[a] = n;
+            lastOnce[a] = percentile(samples, 0.5);
+
+            BenchResult result;
+            result.algorithm = algorithm;
+            result.n = n;
+            result.calls = callCount(algorithm, n);
+            result.samples = int(samples.size());
+            result.batch = batch;
+            result.minNs = samples.front();
+            result.p10Ns = percentile(samples, 0.1);
+            result.medianNs = percentile(samples, 0.5);
+            result.p90Ns = percentile(samples, 0.9);
+            result.maxNs = samples.back();
+            double sum = 0;
+            for (double s : samples) sum += s;
+            result.meanNs = sum / samples.size();
+            report(result);
+        }
+    }
+}
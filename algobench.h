@@ -0,0 +1,61 @@
+#ifndef ALGOBENCH_H
+#define ALGOBENCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Ways of computing F(n) that the algorithm benchmark compares (rows of its list)
+enum BenchAlgorithm {
+    BenchNaive = 0, // exponential recursion on machine words
+    BenchMemo,      // top-down recursion over a table of big integers
+    BenchLoop,      // the linear DP loop (fibLinear)
+    BenchMatrix,    // powers of [[1,1],[1,0]] (fibMatrix)
+    BenchDoubling,  // fast doubling (fibFastDoubling)
+    BenchAlgorithmCount
+};
+
+struct BenchConfig {
+    int nFirst = 10;
+    int nLast = 10000;
+    int points = 12;      // n values, spaced geometrically from nFirst to nLast
+    int warmup = 2;       // untimed samples before the timed ones
+    int repetitions = 15; // timed samples per point
+    bool algorithms[BenchAlgorithmCount] = {true, true, true, true, true};
+};
+
+// Timing statistics of one algorithm at one n. Fast runs are repeated batch times
+// per sample, so a sample is never shorter than the clock can resolve.
+struct BenchResult {
+    BenchAlgorithm algorithm = BenchNaive;
+    int n = 0;
+    uint64_t calls = 0; // see AlgoBench::callCount
+    int samples = 0;
+    int batch = 1;
+    double minNs = 0, p10Ns = 0, medianNs = 0, p90Ns = 0, maxNs = 0, meanNs = 0; // per run
+};
+
+// Runs the algorithms over a range of n with warm-up, repetitions and percentiles.
+// Pure C++, meant for a worker thread; results are reported point by point.
+class AlgoBench {
+public:
+    static const char* algorithmName(BenchAlgorithm algorithm);
+    // largest n an algorithm is run for: naive is exponential, the memo recursion uses the stack,
+    // and the big-integer algorithms stop about where one run takes half a second to a second
+    static int maxN(BenchAlgorithm algorithm);
+    // stack the thread calling run() needs for the memoized recursion at its maxN
+    static size_t stackBytes();
+    // recursive calls, loop iterations, matrix products or doubling steps for F(n)
+    static uint64_t callCount(BenchAlgorithm algorithm, int n);
+    static std::vector<int> nValues(const BenchConfig& config);
+
+    // every n, then every enabled algorithm at it; an algorithm whose single run takes about
+    // a second is sampled a few times and not run for larger n, nor is one whose run at the next
+    // n is predicted (from its last point) to take that long. Returns early once cancel is set:
+    // the big-integer algorithms look at it inside a run, the recursions between runs.
+    static void run(const BenchConfig& config, const std::atomic<bool>& cancel,
+                    const std::function<void(const BenchResult&)>& report);
+};
+
+#endif // ALGOBENCH_H
@@ -0,0 +1,197 @@
+#include "algobenchpanel.h"
+#include "logplot.h"
+#include <QCheckBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QThread>
+#include <QVBoxLayout>
+
+// one color per BenchAlgorithm, shared by both plots
+static const QColor SERIES_COLORS[BenchAlgorithmCount] = {
+    QColor(255, 94, 98), QColor(255, 159, 67), QColor(20, 184, 166), QColor(120, 140, 255), QColor(230, 238, 248)};
+static const char *const CSV_HEADER = "algorithm,n,calls,samples,batch,min_ns,p10_ns,median_ns,p90_ns,max_ns,mean_ns";
+
+AlgoBenchPanel::AlgoBenchPanel(QWidget* parent) : QDialog(parent) {
+    setWindowTitle("Compare algorithms");
+    auto makeSpin = [this](int min, int max, int value) {
+        QSpinBox *spin = new QSpinBox(this);
+        spin->setRange(min, max);
+        spin->setValue(value);
+        return spin;
+    };
+    const BenchConfig defaults;
+    // no algorithm runs past the largest of the per-algorithm limits
+    const int topN = AlgoBench::maxN(BenchDoubling);
+    spinFirst = makeSpin(0, topN, defaults.nFirst);
+    spinLast = makeSpin(0, topN, defaults.nLast);
+    spinPoints = makeSpin(1, 100, defaults.points);
+    spinWarmup = makeSpin(0, 100, defaults.warmup);
+    spinRepetitions = makeSpin(1, 1000, defaults.repetitions);
+
+    QFormLayout *form = new QFormLayout;
+    form->addRow("From n", spinFirst);
+    form->addRow("To n", spinLast);
+    form->addRow("Points (log spaced)", spinPoints);
+    form->addRow("Warm-up runs", spinWarmup);
+    form->addRow("Timed samples", spinRepetitions);
+
+    QVBoxLayout *choices = new QVBoxLayout;
+    for (int a = 0; a < BenchAlgorithmCount; ++a) {
+        const BenchAlgorithm algorithm = BenchAlgorithm(a);
+        const QString label = QString("%1 (n <= %2)").arg(AlgoBench::algorithmName(algorithm)).arg(AlgoBench::maxN(algorithm));
+        checkAlgorithm[a] = new QCheckBox(label, this);
+        checkAlgorithm[a]->setChecked(defaults.algorithms[a]);
+        choices->addWidget(checkAlgorithm[a]);
+    }
+
+    btnRun = new QPushButton("Run", this);
+    btnCancel = new QPushButton("Cancel", this);
+    btnExport = new QPushButton("Export CSV...", this);
+    connect(btnRun, &QPushButton::clicked, this, &AlgoBenchPanel::startRun);
+    connect(btnCancel, &QPushButton::clicked, this, &AlgoBenchPanel::cancelRun);
+    connect(btnExport, &QPushButton::clicked, this, &AlgoBenchPanel::exportCsv);
+    choices->addStretch();
+    choices->addWidget(btnRun);
+    choices->addWidget(btnCancel);
+    choices->addWidget(btnExport);
+
+    timePlot = new LogPlot("Median time per run (whiskers: p10 to p90)", "n", "ns", this);
+    callsPlot = new LogPlot("Calls, iterations or products", "n", "count", this);
+    for (int a = 0; a < BenchAlgorithmCount; ++a) {
+        timePlot->setSeries(a, AlgoBench::algorithmName(BenchAlgorithm(a)), SERIES_COLORS[a]);
+        callsPlot->setSeries(a, AlgoBench::algorithmName(BenchAlgorithm(a)), SERIES_COLORS[a]);
+    }
+
+    table = new QTableWidget(0, 8, this);
+    table->setHorizontalHeaderLabels({"Algorithm", "n", "Calls", "Samples", "Median", "p10", "p90", "Mean"});
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    status = new QLabel("Choose an n range and press Run.", this);
+
+    QHBoxLayout *top = new QHBoxLayout;
+    top->addLayout(form);
+    top->addLayout(choices);
+    top->addWidget(timePlot, 1);
+    top->addWidget(callsPlot, 1);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(top, 3);
+    layout->addWidget(table, 2);
+    layout->addWidget(status);
+    resize(1280, 720);
+    setRunning(false);
+}
+
+AlgoBenchPanel::~AlgoBenchPanel() {
+    // the big-integer runs stop within one product, the recursions after their current run:
+    // at most about half a second for naive F(40), the slowest step below the limits
+    cancelRun();
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+// ---------------- running ----------------
+void AlgoBenchPanel::startRun() {
+    if (thread) return;
+    auto job = std::make_shared<Job>();
+    job->config.nFirst = spinFirst->value();
+    job->config.nLast = spinLast->value();
+    job->config.points = spinPoints->value();
+    job->config.warmup = spinWarmup->value();
+    job->config.repetitions = spinRepetitions->value();
+    for (int a = 0; a < BenchAlgorithmCount; ++a) job->config.algorithms[a] = checkAlgorithm[a]->isChecked();
+    current = job;
+
+    results.clear();
+    table->setRowCount(0);
+    timePlot->clearPoints();
+    callsPlot->clearPoints();
+    status->setText("Running...");
+    setRunning(true);
+
+    // results come back queued to this object, which drops them once it is gone
+    thread = QThread::create([this, job]() {
+        AlgoBench::run(job->config, job->cancel, [this, job](const BenchResult& result) {
+            QMetaObject::invokeMethod(this, [this, job, result]() {
+                if (job == current) addResult(result);
+            }, Qt::QueuedConnection);
+        });
+    });
+    connect(thread, &QThread::finished, this, &AlgoBenchPanel::runFinished);
+    // the platform default may be smaller (512 KB on macOS secondary threads)
+    thread->setStackSize(uint(AlgoBench::stackBytes()));
+    thread->start();
+}
+
+void AlgoBenchPanel::cancelRun() {
+    if (!current) return;
+    current->cancel.store(true);
+    status->setText("Cancelling...");
+}
+
+void AlgoBenchPanel::runFinished() {
+    const bool cancelled = current && current->cancel.load();
+    thread->deleteLater();
+    thread = nullptr;
+    current.reset();
+    setRunning(false);
+    status->setText(QString("%1 points%2").arg(qulonglong(results.size())).arg(cancelled ? " (cancelled)" : ""));
+}
+
+void AlgoBenchPanel::setRunning(bool running) {
+    btnRun->setEnabled(!running);
+    btnCancel->setEnabled(running);
+    btnExport->setEnabled(!running && !results.empty());
+}
+
+void AlgoBenchPanel::addResult(const BenchResult& r) {
+    results.push_back(r);
+    timePlot->addPoint(r.algorithm, r.n, r.medianNs, r.p10Ns, r.p90Ns);
+    callsPlot->addPoint(r.algorithm, r.n, double(r.calls));
+
+    auto timeText = [](double ns) {
+        if (ns >= 1e6) return QString("%1 ms").arg(ns / 1e6, 0, 'f', 3);
+        if (ns >= 1e3) return QString("%1 us").arg(ns / 1e3, 0, 'f', 2);
+        return QString("%1 ns").arg(ns, 0, 'f', 1);
+    };
+    const int row = table->rowCount();
+    table->insertRow(row);
+    const QStringList cells = {AlgoBench::algorithmName(r.algorithm), QString::number(r.n), QString::number(qulonglong(r.calls)),
+                               QString("%1 x %2").arg(r.samples).arg(r.batch), timeText(r.medianNs), timeText(r.p10Ns),
+                               timeText(r.p90Ns), timeText(r.meanNs)};
+    for (int c = 0; c < cells.size(); ++c) table->setItem(row, c, new QTableWidgetItem(cells[c]));
+    table->scrollToBottom();
+    status->setText(QString("%1, n = %2: median %3").arg(QString(AlgoBench::algorithmName(r.algorithm))).arg(r.n)
+                    .arg(timeText(r.medianNs)));
+}
+
+// ---------------- CSV ----------------
+void AlgoBenchPanel::exportCsv() {
+    QString path = QFileDialog::getSaveFileName(this, "Export CSV", "fib_algorithms.csv", "CSV (*.csv)");
+    if (path.isEmpty()) return;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "Export failed", QString("Cannot write %1: %2").arg(path, file.errorString()));
+        return;
+    }
+    QTextStream csv(&file);
+    csv << CSV_HEADER << "\n";
+    for (const BenchResult &r : results) {
+        csv << AlgoBench::algorithmName(r.algorithm) << "," << r.n << "," << qulonglong(r.calls) << "," << r.samples << ","
+            << r.batch;
+        for (double ns : {r.minNs, r.p10Ns, r.medianNs, r.p90Ns, r.maxNs, r.meanNs}) csv << "," << QString::number(ns, 'f', 1);
+        csv << "\n";
+    }
+    status->setText(QString("Saved %1 points to %2").arg(qulonglong(results.size())).arg(path));
+}
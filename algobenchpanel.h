@@ -0,0 +1,53 @@
+#ifndef ALGOBENCHPANEL_H
+#define ALGOBENCHPANEL_H
+
+#include <QDialog>
+#include <memory>
+#include <vector>
+#include "algobench.h"
+
+class QCheckBox;
+class QLabel;
+class QPushButton;
+class QSpinBox;
+class QTableWidget;
+class QThread;
+class LogPlot;
+
+// Window comparing the ways of computing F(n) over an n range. AlgoBench runs on a worker
+// thread and reports each point, which is added to the table and to the time and call plots
+// as it arrives; the results can be saved as CSV.
+class AlgoBenchPanel : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit AlgoBenchPanel(QWidget* parent = nullptr);
+    ~AlgoBenchPanel() override; // cancels the run and waits for its thread
+
+private slots:
+    void startRun();
+    void cancelRun();
+    void exportCsv();
+
+private:
+    struct Job {
+        BenchConfig config;
+        std::atomic<bool> cancel{false};
+    };
+    std::shared_ptr<Job> current;
+    QThread* thread = nullptr;
+    std::vector<BenchResult> results;
+
+    QSpinBox *spinFirst, *spinLast, *spinPoints, *spinWarmup, *spinRepetitions;
+    QCheckBox* checkAlgorithm[BenchAlgorithmCount];
+    QPushButton *btnRun, *btnCancel, *btnExport;
+    QLabel* status;
+    LogPlot *timePlot, *callsPlot;
+    QTableWidget* table;
+
+    void addResult(const BenchResult& result);
+    void runFinished();
+    void setRunning(bool running);
+};
+
+#endif // ALGOBENCHPANEL_H
@@ -0,0 +1,89 @@
+#include "allocstats.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+static std::atomic<std::uint64_t> allocCount{0};
+static std::atomic<std::uint64_t> allocBytes{0};
+
+// ---------------- counting operator new ----------------
+// Only sizes and counts are recorded; memory still comes from malloc. Replacing the global
+// operators affects every allocation of the process, so only the benchmark enables them.
+#ifdef ALLOCSTATS_COUNTING
+void* operator new(std::size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
+
+// ---------------- queries ----------------
+bool AllocStats::counting() {
+#ifdef ALLOCSTATS_COUNTING
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocStats AllocStats::now() {
+    return {allocCount.load(std::memory_order_relaxed), allocBytes.load(std::memory_order_relaxed)};
+}
+
+size_t AllocStats::peakRssBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return size_t(usage.ru_maxrss);        // bytes
+#else
+    return size_t(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
+
+size_t AllocStats::physicalMemoryBytes() {
+#if defined(_WIN32)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) return size_t(status.ullTotalPhys);
+    return 0;
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && pageSize > 0 ? size_t(pages) * size_t(pageSize) : 0;
+#endif
+}
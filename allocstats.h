@@ -0,0 +1,22 @@
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide heap counters, fed by the global operator new in allocstats.cpp when it is
+// built with ALLOCSTATS_COUNTING (the benchmark target only; they stay zero otherwise),
+// and the peak resident set size and installed memory as reported by the OS.
+struct AllocStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+
+    static bool counting(); // the operator new hooks are compiled in
+    static AllocStats now();
+    static size_t peakRssBytes();
+    static size_t physicalMemoryBytes(); // 0 when unknown
+
+    AllocStats operator-(const AllocStats& o) const { return {allocations - o.allocations, bytes - o.bytes}; }
+};
+
+#endif // ALLOCSTATS_H
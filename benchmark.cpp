@@ -0,0 +1,48 @@
+#include <QApplication>
+#include <QDir>
+#include <QTextStream>
+#include <algorithm>
+#include "headless.h"
+
+// Standard sweeps, one per hot path. Each runs the headless pipeline with these arguments.
+struct Suite {
+    const char* name;
+    QStringList args;
+};
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    // fibonacci_benchmark [--out DIR] [--baseline-dir DIR] runs the standard sweeps;
+    // any other arguments make a single custom run with the app's --headless options
+    QStringList args = a.arguments();
+    QString outDir, baselineDir;
+    for (int i = 1; i < args.size(); ++i) {
+        if (i + 1 < args.size() && args[i] == "--out") outDir = args[++i];
+        else if (i + 1 < args.size() && args[i] == "--baseline-dir") baselineDir = args[++i];
+        else return runHeadless(args);
+    }
+    if (!outDir.isEmpty()) QDir().mkpath(outDir);
+
+    const QList<Suite> suites = {
+        {"naive-serial", {"--mode", "naive", "--renderer", "batched", "--threads", "0", "--n", "15-27:3", "--render"}},
+        {"naive-parallel", {"--mode", "naive", "--renderer", "batched", "--n", "15-27:3", "--render"}},
+        {"naive-items", {"--mode", "naive", "--renderer", "items", "--n", "8-14:2", "--render"}},
+        {"memo-virtual", {"--mode", "memo", "--renderer", "virtual", "--n", "1000,10000,100000", "--render"}},
+        {"implicit", {"--renderer", "implicit", "--n", "30,60,90", "--render"}},
+    };
+
+    QTextStream out(stdout);
+    int exitCode = 0;
+    for (const Suite &suite : suites) {
+        out << "\n== " << suite.name << " ==\n";
+        out.flush();
+        QStringList runArgs = QStringList{args.first()} + suite.args;
+        if (!outDir.isEmpty()) runArgs << "--csv" << QDir(outDir).filePath(QString(suite.name) + ".csv");
+        if (!baselineDir.isEmpty()) runArgs << "--baseline" << QDir(baselineDir).filePath(QString(suite.name) + ".csv");
+        exitCode = std::max(exitCode, runHeadless(runArgs));
+    }
+    return exitCode;
+}
@@ -0,0 +1,271 @@
+#include "bigint.h"
+#include <algorithm>
+#include <cmath>
+
+using u128 = unsigned __int128;
+
+size_t BigUInt::karatsubaThreshold = 32;
+
+BigUInt::BigUInt(uint64_t v) {
+    if (v) limbs.push_back(v);
+}
+
+void BigUInt::trim() {
+    while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+}
+
+size_t BigUInt::bitLength() const {
+    if (limbs.empty()) return 0;
+    uint64_t top = limbs.back();
+    size_t bits = 0;
+    while (top) { ++bits; top >>= 1; }
+    return (limbs.size() - 1) * 64 + bits;
+}
+
+// ---------------- limb kernels ----------------
+// x[0..nx) += y[0..ny), nx >= ny; returns the carry out of x
+static uint64_t addInto(uint64_t* x, size_t nx, const uint64_t* y, size_t ny) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < ny; ++i) {
+        u128 s = u128(x[i]) + y[i] + carry;
+        x[i] = uint64_t(s);
+        carry = uint64_t(s >> 64);
+    }
+    for (; carry && i < nx; ++i) {
+        x[i] += 1;
+        carry = x[i] == 0;
+    }
+    return carry;
+}
+
+// x[0..nx) -= y[0..ny), nx >= ny and x >= y
+static void subFrom(uint64_t* x, size_t nx, const uint64_t* y, size_t ny) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < ny; ++i) {
+        uint64_t yi = y[i] + borrow;
+        uint64_t nb = (yi < borrow) || (x[i] < yi);
+        x[i] -= yi;
+        borrow = nb;
+    }
+    for (; borrow && i < nx; ++i) {
+        borrow = x[i] == 0;
+        x[i] -= 1;
+    }
+}
+
+// out[0..na+nb) = a * b (out must not alias the inputs)
+static void mulSchool(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* out) {
+    std::fill(out, out + na + nb, 0);
+    for (size_t i = 0; i < na; ++i) {
+        uint64_t carry = 0;
+        const uint64_t ai = a[i];
+        for (size_t j = 0; j < nb; ++j) {
+            u128 t = u128(ai) * b[j] + out[i + j] + carry;
+            out[i + j] = uint64_t(t);
+            carry = uint64_t(t >> 64);
+        }
+        out[i + nb] = carry;
+    }
+}
+
+// out[0..2n) = a * b for two n-limb operands
+static void mulKaratsuba(const uint64_t* a, const uint64_t* b, size_t n, uint64_t* out) {
+    if (n < BigUInt::karatsubaThreshold) {
+        mulSchool(a, n, b, n, out);
+        return;
+    }
+    const size_t m = n / 2, h = n - m; // low halves have m limbs, high halves h >= m
+
+    // z0 = a0*b0 in out[0..2m), z2 = a1*b1 in out[2m..2n)
+    mulKaratsuba(a, b, m, out);
+    mulKaratsuba(a + m, b + m, h, out + 2 * m);
+
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2
+    std::vector<uint64_t> sa(h + 1, 0), sb(h + 1, 0);
+    std::copy(a + m, a + n, sa.begin());
+    std::copy(b + m, b + n, sb.begin());
+    sa[h] = addInto(sa.data(), h, a, m);
+    sb[h] = addInto(sb.data(), h, b, m);
+    std::vector<uint64_t> z1(2 * (h + 1));
+    mulKaratsuba(sa.data(), sb.data(), h + 1, z1.data());
+    subFrom(z1.data(), z1.size(), out, 2 * m);
+    subFrom(z1.data(), z1.size(), out + 2 * m, 2 * h);
+
+    // the middle term fits in 2n - m limbs; anything above is zero
+    size_t len = std::min(z1.size(), 2 * n - m);
+    addInto(out + m, 2 * n - m, z1.data(), len);
+}
+
+BigUInt operator*(const BigUInt& a, const BigUInt& b) {
+    BigUInt r;
+    if (a.isZero() || b.isZero()) return r;
+    const BigUInt &big = a.limbs.size() >= b.limbs.size() ? a : b;
+    const BigUInt &small = &big == &a ? b : a;
+    const size_t nb = big.limbs.size(), ns = small.limbs.size();
+    r.limbs.assign(nb + ns, 0);
+
+    if (ns < BigUInt::karatsubaThreshold) {
+        mulSchool(big.limbs.data(), nb, small.limbs.data(), ns, r.limbs.data());
+    } else {
+        // multiply ns-limb chunks of the longer operand by the shorter one and accumulate
+        std::vector<uint64_t> chunk(ns), prod(2 * ns);
+        for (size_t off = 0; off < nb; off += ns) {
+            size_t len = std::min(ns, nb - off);
+            std::fill(chunk.begin(), chunk.end(), 0);
+            std::copy(big.limbs.begin() + off, big.limbs.begin() + off + len, chunk.begin());
+            mulKaratsuba(chunk.data(), small.limbs.data(), ns, prod.data());
+            addInto(r.limbs.data() + off, r.limbs.size() - off, prod.data(), std::min(prod.size(), r.limbs.size() - off));
+        }
+    }
+    r.trim();
+    return r;
+}
+
+// ---------------- add / sub ----------------
+BigUInt& BigUInt::operator+=(const BigUInt& o) {
+    if (limbs.size() < o.limbs.size()) limbs.resize(o.limbs.size(), 0);
+    if (addInto(limbs.data(), limbs.size(), o.limbs.data(), o.limbs.size())) limbs.push_back(1);
+    return *this;
+}
+
+BigUInt& BigUInt::operator-=(const BigUInt& o) {
+    subFrom(limbs.data(), limbs.size(), o.limbs.data(), o.limbs.size());
+    trim();
+    return *this;
+}
+
+// ---------------- decimal conversion ----------------
+uint64_t BigUInt::divSmall(uint64_t divisor) {
+    u128 rem = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        u128 cur = (rem << 64) | limbs[i];
+        limbs[i] = uint64_t(cur / divisor);
+        rem = cur % divisor;
+    }
+    trim();
+    return uint64_t(rem);
+}
+
+// log10 of the value as integer part + fraction in [0, 1). A plain double log10 of a
+// number with millions of digits leaves too few fraction bits for the leading digits,
+// so log10(2) is split into a 24-bit head (exact when multiplied by the exponent) and a tail.
+static const double LOG10_2_HI = 5050445.0 / 16777216.0;
+static const double LOG10_2_LO = 1.5481333490135613894724493e-8;
+
+static void log10Of(const std::vector<uint64_t>& limbs, int64_t& whole, double& frac) {
+    const size_t n = limbs.size();
+    double top = double(limbs[n-1]) * 18446744073709551616.0 + (n > 1 ? double(limbs[n-2]) : 0.0);
+    int e = 0;
+    double m = std::frexp(top, &e); // top = m * 2^e, m in [0.5, 1)
+    double exp2 = double(e) + (n > 1 ? 64.0 * double(n - 2) : -64.0);
+
+    double hi = exp2 * LOG10_2_HI;
+    double hiWhole = std::floor(hi);
+    double rest = (hi - hiWhole) + exp2 * LOG10_2_LO + std::log10(m);
+    double restWhole = std::floor(rest);
+    whole = int64_t(hiWhole) + int64_t(restWhole);
+    frac = rest - restWhole;
+}
+
+size_t BigUInt::decimalDigits() const {
+    if (limbs.empty()) return 1;
+    if (fitsU64()) return std::to_string(limbs[0]).size();
+    int64_t whole;
+    double frac;
+    log10Of(limbs, whole, frac);
+    return size_t(whole) + 1;
+}
+
+std::string BigUInt::toString() const {
+    if (limbs.empty()) return "0";
+    const uint64_t chunkBase = 10000000000000000000ull; // 10^19
+    BigUInt tmp = *this;
+    std::vector<uint64_t> chunks;
+    while (!tmp.isZero()) chunks.push_back(tmp.divSmall(chunkBase));
+    std::string s = std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        std::string part = std::to_string(chunks[i]);
+        s.append(19 - part.size(), '0');
+        s += part;
+    }
+    return s;
+}
+
+std::string BigUInt::leadingDigits(int count) const {
+    // the fraction of log10 alone fixes the leading digits
+    int64_t whole;
+    double frac;
+    log10Of(limbs, whole, frac);
+    double lead = std::floor(std::pow(10.0, frac + count - 1));
+    return std::to_string(uint64_t(lead)).substr(0, size_t(count));
+}
+
+std::string BigUInt::trailingDigits(int count) const {
+    uint64_t mod = 1;
+    for (int i = 0; i < count; ++i) mod *= 10;
+    BigUInt tmp = *this;
+    std::string tail = std::to_string(tmp.divSmall(mod));
+    tail.insert(0, size_t(count) - tail.size(), '0');
+    return tail;
+}
+
+std::string BigUInt::summary(int edgeDigits) const {
+    const size_t digits = decimalDigits();
+    if (digits <= size_t(2 * edgeDigits + 3)) return toString();
+    return leadingDigits(edgeDigits) + "..." + trailingDigits(edgeDigits) + " (" + std::to_string(digits) + " digits)";
+}
+
+// ---------------- Fibonacci ----------------
+// iterations of the linear loop between two looks at the cancel flag
+static const uint64_t LINEAR_CANCEL_INTERVAL = 1024;
+
+static bool cancelled(const std::atomic<bool>* cancel) {
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+BigUInt fibFastDoubling(uint64_t n, const std::atomic<bool>* cancel) {
+    // invariant: (a, b) = (F(k), F(k+1)) for the bits of n consumed so far
+    BigUInt a(0), b(1);
+    int top = 63;
+    while (top >= 0 && !((n >> top) & 1)) --top;
+    for (int bit = top; bit >= 0 && !cancelled(cancel); --bit) {
+        BigUInt twoB = b + b;
+        BigUInt c = a * (twoB - a);   // F(2k)   = F(k) * (2F(k+1) - F(k))
+        BigUInt d = a * a + b * b;    // F(2k+1) = F(k)^2 + F(k+1)^2
+        if ((n >> bit) & 1) {
+            a = d;
+            b = std::move(c += d);
+        } else {
+            a = std::move(c);
+            b = std::move(d);
+        }
+    }
+    return a;
+}
+
+BigUInt fibLinear(uint64_t n, const std::atomic<bool>* cancel) {
+    BigUInt a(0), b(1);
+    for (uint64_t i = 0; i < n; ++i) {
+        if (i % LINEAR_CANCEL_INTERVAL == 0 && cancelled(cancel)) break;
+        a += b;
+        std::swap(a, b);
+    }
+    return a;
+}
+
+BigUInt fibMatrix(uint64_t n, const std::atomic<bool>* cancel) {
+    // powers of Q = [[1,1],[1,0]] are symmetric: [[F(k+1), F(k)], [F(k), F(k-1)]], kept as (a, b, c)
+    struct Sym { BigUInt a, b, c; };
+    auto mul = [](const Sym& x, const Sym& y) {
+        return Sym{x.a * y.a + x.b * y.b, x.a * y.b + x.b * y.c, x.b * y.b + x.c * y.c};
+    };
+    Sym result{BigUInt(1), BigUInt(0), BigUInt(1)};
+    Sym power{BigUInt(1), BigUInt(1), BigUInt(0)};
+    for (; n > 0 && !cancelled(cancel); n >>= 1) {
+        if (n & 1) result = mul(result, power);
+        if (n > 1) power = mul(power, power);
+    }
+    return result.b;
+}
@@ -0,0 +1,56 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Arbitrary-precision unsigned integer on 64-bit limbs (little endian).
+// Multiplication switches from schoolbook to Karatsuba above karatsubaThreshold limbs.
+class BigUInt {
+public:
+    BigUInt() = default;
+    BigUInt(uint64_t v);
+
+    bool isZero() const { return limbs.empty(); }
+    size_t limbCount() const { return limbs.size(); }
+    size_t bitLength() const;
+    bool fitsU64() const { return limbs.size() <= 1; }
+    uint64_t toU64() const { return limbs.empty() ? 0 : limbs[0]; }
+
+    BigUInt& operator+=(const BigUInt& o);
+    BigUInt& operator-=(const BigUInt& o); // requires *this >= o
+    friend BigUInt operator+(BigUInt a, const BigUInt& b) { return a += b; }
+    friend BigUInt operator-(BigUInt a, const BigUInt& b) { return a -= b; }
+    friend BigUInt operator*(const BigUInt& a, const BigUInt& b);
+    friend bool operator==(const BigUInt& a, const BigUInt& b) { return a.limbs == b.limbs; }
+
+    // divide in place by a small divisor, returning the remainder
+    uint64_t divSmall(uint64_t divisor);
+
+    size_t decimalDigits() const;
+    std::string toString() const;                  // O(limbs^2), fine up to a few hundred thousand digits
+    std::string summary(int edgeDigits = 12) const; // "leading...trailing (N digits)" for long values
+    std::string leadingDigits(int count) const;     // count <= 15, value must have more digits
+    std::string trailingDigits(int count) const;    // count <= 19, zero padded
+
+    static size_t karatsubaThreshold;
+
+private:
+    std::vector<uint64_t> limbs; // no leading zero limbs
+    void trim();
+};
+
+// The F(n) algorithms below stop early once *cancel is set, returning a meaningless value;
+// they look at it between doubling steps, matrix products or every few loop iterations.
+
+// F(n) by fast doubling: O(log n) big multiplications
+BigUInt fibFastDoubling(uint64_t n, const std::atomic<bool>* cancel = nullptr);
+// F(n) by the linear DP loop on big integers, kept for comparison
+BigUInt fibLinear(uint64_t n, const std::atomic<bool>* cancel = nullptr);
+// F(n) as an entry of [[1,1],[1,0]]^n, by repeated squaring: O(log n) matrix products
+BigUInt fibMatrix(uint64_t n, const std::atomic<bool>* cancel = nullptr);
+
+#endif // BIGINT_H
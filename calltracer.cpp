@@ -0,0 +1,226 @@
+#include "calltracer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CALLTRACER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CALLTRACER_TSC 1
+#endif
+
+// events the ring holds (1 MB); the drain thread keeps it far from full
+static const size_t RING_EVENTS = size_t(1) << 16;
+
+// ---------------- ring ----------------
+TraceRing::TraceRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    slots.resize(size);
+    mask = size - 1;
+}
+
+size_t TraceRing::drain(std::vector<TraceEvent>& out) {
+    const uint64_t t = tail.load(std::memory_order_relaxed);
+    const uint64_t h = head.load(std::memory_order_acquire);
+    for (uint64_t i = t; i < h; ++i) out.push_back(slots[i & mask]);
+    tail.store(h, std::memory_order_release);
+    return size_t(h - t);
+}
+
+// ---------------- traced algorithms ----------------
+namespace {
+
+// probes compile away in the untraced runs
+template <bool Traced>
+struct Probe {
+    TraceRing* ring;
+    void enter(int k, uint32_t flags = 0) {
+        if (Traced) ring->push(CallTracer::ticks(), k, flags);
+    }
+    void exit(int k, uint32_t flags = 0) {
+        if (Traced) ring->push(CallTracer::ticks(), k, TRACE_EXIT | flags);
+    }
+};
+
+template <bool Traced>
+uint64_t naiveFib(Probe<Traced>& probe, int k) {
+    probe.enter(k);
+    const uint64_t value = k < 2 ? uint64_t(k) : naiveFib(probe, k - 1) + naiveFib(probe, k - 2);
+    probe.exit(k);
+    return value;
+}
+
+// the table is looked at before the base cases, which gives the memo tree's shape
+template <bool Traced>
+uint64_t memoFib(Probe<Traced>& probe, int k, std::vector<uint64_t>& memo, std::vector<std::uint8_t>& known) {
+    if (known[k]) {
+        probe.enter(k, TRACE_CACHED);
+        probe.exit(k, TRACE_CACHED);
+        return memo[k];
+    }
+    probe.enter(k);
+    const uint64_t value = k < 2 ? uint64_t(k) : memoFib(probe, k - 1, memo, known) + memoFib(probe, k - 2, memo, known);
+    memo[k] = value;
+    known[k] = 1;
+    probe.exit(k);
+    return value;
+}
+
+template <bool Traced>
+uint64_t iterativeFib(Probe<Traced>& probe, int n) {
+    probe.enter(n);
+    uint64_t a = 0, b = 1;
+    for (int i = 2; i <= n; ++i) {
+        probe.enter(i);
+        const uint64_t c = a + b;
+        a = b;
+        b = c;
+        probe.exit(i);
+    }
+    probe.exit(n);
+    return n == 0 ? 0 : b;
+}
+
+template <bool Traced>
+uint64_t run(TraceAlgorithm algorithm, int n, Probe<Traced>& probe) {
+    if (algorithm == TraceNaive) return naiveFib(probe, n);
+    if (algorithm == TraceIterative) return iterativeFib(probe, n);
+    std::vector<uint64_t> memo(size_t(n) + 1, 0);
+    std::vector<std::uint8_t> known(size_t(n) + 1, 0);
+    return memoFib(probe, n, memo, known);
+}
+
+// Turns the event stream back into the preorder arena as it is drained: an enter is the
+// next node, under the call on top of the stack; its exit closes the node's times.
+struct Rebuilder {
+    struct Frame {
+        NodeId id;
+        uint64_t enter;
+        uint64_t childTicks; // inclusive time of the calls it made
+        NodeId lastChild;
+    };
+    CallTrace* out = nullptr;
+    NodeId next = 0;
+    std::vector<Frame> stack = {};
+
+    void add(const TraceEvent& e) {
+        CallTree& t = out->tree;
+        if ((e.flags & TRACE_EXIT) == 0) {
+            const NodeId id = next++;
+            t.n[id] = e.n;
+            t.cached[id] = (e.flags & TRACE_CACHED) ? 1 : 0;
+            t.depth[id] = int(stack.size());
+            if (!stack.empty()) {
+                Frame& top = stack.back();
+                t.parent[id] = top.id;
+                if (top.lastChild == NO_NODE) t.firstChild[top.id] = id;
+                else t.nextSibling[top.lastChild] = id;
+                top.lastChild = id;
+            }
+            stack.push_back({id, e.ticks, 0, NO_NODE});
+            return;
+        }
+        const Frame f = stack.back();
+        stack.pop_back();
+        const uint64_t inclusive = e.ticks - f.enter;
+        out->inclusiveTicks[f.id] = inclusive;
+        out->exclusiveTicks[f.id] = inclusive - std::min(inclusive, f.childTicks);
+        if (!stack.empty()) stack.back().childTicks += inclusive;
+    }
+};
+
+// log scale between the shortest and the longest time
+void assignHeat(const std::vector<uint64_t>& ticks, std::vector<NodeHeat>& heat, std::uint8_t NodeHeat::*field) {
+    const auto [lo, hi] = std::minmax_element(ticks.begin(), ticks.end());
+    const double low = std::log1p(double(*lo));
+    const double range = std::max(1e-9, std::log1p(double(*hi)) - low);
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        heat[i].*field = std::uint8_t(1 + std::lround(254.0 * (std::log1p(double(ticks[i])) - low) / range));
+    }
+}
+
+} // namespace
+
+// ---------------- tracer ----------------
+uint64_t CallTracer::ticks() {
+#ifdef CALLTRACER_TSC
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+uint64_t CallTracer::callCount(TraceAlgorithm algorithm, int n) {
+    if (algorithm == TraceNaive) return CallTree::naiveNodeCount(n);
+    if (algorithm == TraceMemo) return CallTree::memoNodeCount(n);
+    return n < 2 ? 1 : uint64_t(n);
+}
+
+int CallTracer::recursionDepth(TraceAlgorithm algorithm, int n) {
+    return algorithm == TraceIterative ? 2 : n + 1;
+}
+
+const char* CallTracer::algorithmName(TraceAlgorithm algorithm) {
+    switch (algorithm) {
+    case TraceNaive: return "naive recursion";
+    case TraceMemo: return "memoized recursion";
+    default: return "iterative loop";
+    }
+}
+
+void CallTracer::trace(TraceAlgorithm algorithm, int n, double vertGap, CallTrace* out) {
+    PROFILE_SCOPE("trace run");
+    using Clock = std::chrono::steady_clock;
+    *out = CallTrace();
+
+    // without probes first, which also warms what the traced run touches
+    {
+        Probe<false> probe{nullptr};
+        const Clock::time_point start = Clock::now();
+        volatile uint64_t value = run(algorithm, n, probe);
+        (void)value;
+        out->untracedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const size_t calls = size_t(callCount(algorithm, n));
+    out->tree.allocate(calls);
+    out->inclusiveTicks.assign(calls, 0);
+    out->exclusiveTicks.assign(calls, 0);
+
+    // the drain thread rebuilds the tree while the run is still pushing
+    TraceRing ring(RING_EVENTS);
+    std::atomic<bool> done{false};
+    std::thread drainer([&ring, &done, out]() {
+        Rebuilder rebuilder{out};
+        std::vector<TraceEvent> chunk;
+        chunk.reserve(RING_EVENTS);
+        for (bool last = false; !last;) {
+            last = done.load(std::memory_order_acquire);
+            chunk.clear();
+            if (ring.drain(chunk) == 0 && !last) std::this_thread::yield();
+            for (const TraceEvent& e : chunk) rebuilder.add(e);
+            out->events += chunk.size();
+        }
+    });
+
+    Probe<true> probe{&ring};
+    const Clock::time_point start = Clock::now();
+    const uint64_t firstTick = ticks();
+    out->value = run(algorithm, n, probe);
+    const uint64_t lastTick = ticks();
+    const double wallNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    done.store(true, std::memory_order_release);
+    drainer.join();
+    out->tracedMs = wallNs / 1e6;
+    out->nsPerTick = lastTick > firstTick ? wallNs / double(lastTick - firstTick) : 1.0;
+
+    out->tree.assignPositions(vertGap);
+    out->heat.assign(calls, NodeHeat());
+    assignHeat(out->inclusiveTicks, out->heat, &NodeHeat::inclusive);
+    assignHeat(out->exclusiveTicks, out->heat, &NodeHeat::exclusive);
+}
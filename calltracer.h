@@ -0,0 +1,87 @@
+#ifndef CALLTRACER_H
+#define CALLTRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "calltree.h"
+
+// Algorithms the tracer runs for real (index into the Trace menu)
+enum TraceAlgorithm {
+    TraceNaive = 0, // fib(k) = fib(k-1) + fib(k-2)
+    TraceMemo,      // the same recursion over a memo table
+    TraceIterative, // one loop; every iteration is recorded as a call under F(n)
+    TraceAlgorithmCount
+};
+
+// One probe hit: a call of F(n) entered or returned, stamped with the cycle counter
+struct TraceEvent {
+    uint64_t ticks;
+    int32_t n;
+    uint32_t flags;
+};
+static const uint32_t TRACE_EXIT = 1;   // return, otherwise enter
+static const uint32_t TRACE_CACHED = 2; // answered from the memo table
+
+// Single-producer single-consumer ring of trace events, allocated once. The traced code
+// pushes while a drain thread empties it; the producer only waits when the ring is full.
+class TraceRing {
+public:
+    explicit TraceRing(size_t capacity); // rounded up to a power of two
+
+    void push(uint64_t ticks, int32_t n, uint32_t flags) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tailSeen == slots.size()) {
+            while (h - (tailSeen = tail.load(std::memory_order_acquire)) == slots.size()) std::this_thread::yield();
+        }
+        slots[h & mask] = {ticks, n, flags};
+        head.store(h + 1, std::memory_order_release);
+    }
+    // consumer: appends the events published so far to out; returns how many
+    size_t drain(std::vector<TraceEvent>& out);
+
+private:
+    std::vector<TraceEvent> slots;
+    uint64_t mask;
+    uint64_t tailSeen = 0; // producer's last look at tail
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+};
+
+// Measured time of one traced call on a log scale, 1..255 (0: the tree was not traced)
+struct NodeHeat {
+    std::uint8_t inclusive = 0;
+    std::uint8_t exclusive = 0;
+};
+
+// A real run rebuilt as a call tree, with the time of every call
+struct CallTrace {
+    CallTree tree;                       // preorder, laid out
+    std::vector<uint64_t> inclusiveTicks; // by NodeId
+    std::vector<uint64_t> exclusiveTicks; // inclusive minus the calls it made
+    std::vector<NodeHeat> heat;
+    uint64_t value = 0;    // F(n) modulo 2^64, as the algorithm returned it
+    uint64_t events = 0;
+    double nsPerTick = 1.0;
+    double tracedMs = 0.0;   // the traced run, probes included
+    double untracedMs = 0.0; // the same run without probes
+
+    double ns(uint64_t ticks) const { return ticks * nsPerTick; }
+};
+
+// Runs fib(n) with enter/exit probes stamped by the TSC (steady clock where there is none).
+// Events go through a TraceRing to a drain thread and are rebuilt into a CallTrace.
+// Recursion runs on the calling thread's stack, so callers bound n (see recursionDepth).
+class CallTracer {
+public:
+    static uint64_t ticks();
+    // calls the traced run makes, and how deep its recursion goes
+    static uint64_t callCount(TraceAlgorithm algorithm, int n);
+    static int recursionDepth(TraceAlgorithm algorithm, int n);
+
+    static void trace(TraceAlgorithm algorithm, int n, double vertGap, CallTrace* out);
+    static const char* algorithmName(TraceAlgorithm algorithm);
+};
+
+#endif // CALLTRACER_H
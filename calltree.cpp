@@ -0,0 +1,283 @@
+#include "calltree.h"
+#include "implicittree.h"
+#include "profiler.h"
+#include "recurrence.h"
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// parallel naive builder: subtrees with fewer nodes are built by one worker without forking
+static const uint64_t FORK_CUTOFF = 1u << 14;
+
+// ---------------- storage ----------------
+int CallTree::childCount(NodeId id) const {
+    int count = 0;
+    for (NodeId c = firstChild[id]; c != NO_NODE; c = nextSibling[c]) ++count;
+    return count;
+}
+
+size_t CallTree::naiveNodeCount(int fibN) {
+    // the subtree of F(k) has 2*F(k+1) - 1 nodes
+    return FibonacciRecurrence::naiveNodeCount(fibN);
+}
+
+size_t CallTree::memoNodeCount(int fibN) {
+    // F(n)..F(0) once each, plus one cached leaf for every F(k), k >= 3
+    return FibonacciRecurrence::memoNodeCount(fibN);
+}
+
+size_t CallTree::naiveNodeCount(RecurrenceRule rule, int n) {
+    return visitRecurrence(rule, [n](auto r) { return decltype(r)::naiveNodeCount(n); });
+}
+
+size_t CallTree::memoNodeCount(RecurrenceRule rule, int n) {
+    return visitRecurrence(rule, [n](auto r) { return decltype(r)::memoNodeCount(n); });
+}
+
+void CallTree::allocate(size_t count) {
+    // one exact allocation per array; builders then write nodes by index. Ids are 32-bit and
+    // NO_NODE is reserved, so callers size trees first (ResourceGovernor refuses larger ones)
+    assert(count < NO_NODE && "node ids are 32-bit");
+    clear();
+    n.resize(count, 0);
+    parent.resize(count, NO_NODE);
+    firstChild.resize(count, NO_NODE);
+    nextSibling.resize(count, NO_NODE);
+    depth.resize(count, 0);
+    x.resize(count, 0.0);
+    y.resize(count, 0.0);
+    cached.resize(count, 0);
+}
+
+void CallTree::clear() {
+    // move-assign a fresh arena so every array is freed in one go
+    *this = CallTree();
+}
+
+void CallTree::setNode(NodeId id, int fibN, NodeId p) {
+    n[id] = fibN;
+    parent[id] = p;
+    if (p == NO_NODE) return;
+    depth[id] = depth[p] + 1;
+    if (firstChild[p] == NO_NODE) {
+        firstChild[p] = id;
+    } else {
+        NodeId last = firstChild[p];
+        while (nextSibling[last] != NO_NODE) last = nextSibling[last];
+        nextSibling[last] = id;
+    }
+}
+
+NodeId CallTree::lastChild(NodeId id) const {
+    NodeId last = firstChild[id];
+    if (last == NO_NODE) return NO_NODE;
+    while (nextSibling[last] != NO_NODE) last = nextSibling[last];
+    return last;
+}
+
+// ---------------- build trees ----------------
+NodeId CallTree::buildNaiveFib(int fibN, BuildControl* control) {
+    PROFILE_SCOPE("build naive");
+    // x comes from the recurrence tables; assignPositions sets the rows
+    return FibonacciRecurrence::buildNaive(*this, fibN, 0.0, control);
+}
+
+// ---------------- parallel naive build ----------------
+// the recurrence engine's compile-time tables are read directly by the hot loops
+static_assert(ImplicitFibTree::MAX_N <= FibonacciRecurrence::MAX_N, "the parallel builder reads tables up to MAX_N");
+
+void CallTree::writeNaiveNode(const NaiveCall& call, double vertGap) {
+    const RecurrenceTables &shape = FibonacciRecurrence::TABLES;
+    const NodeId id = call.id;
+    n[id] = call.fibN;
+    parent[id] = call.parent;
+    depth[id] = call.depth;
+    // F(k-1) starts right after its parent, F(k-2) after the whole F(k-1) subtree
+    if (call.fibN > 1) {
+        firstChild[id] = id + 1;
+        nextSibling[id + 1] = NodeId(id + 1 + shape.size[call.fibN - 1]);
+    }
+    // same slots assignPositions gives: leaves left to right, parents centered over their children
+    x[id] = double(call.leafStart) + shape.relX[call.fibN];
+    y[id] = call.depth * vertGap;
+}
+
+bool CallTree::fillNaiveSubtree(const NaiveCall& root, double vertGap, BuildControl* control) {
+    PROFILE_SCOPE("build naive subtree");
+    const RecurrenceTables &shape = FibonacciRecurrence::TABLES;
+    std::vector<NaiveCall> stack;
+    stack.reserve(size_t(root.fibN) + 2);
+    stack.push_back(root);
+    NodeId written = 0;
+    while (!stack.empty()) {
+        NaiveCall call = stack.back();
+        stack.pop_back();
+        writeNaiveNode(call, vertGap);
+        if (call.fibN > 1) {
+            const int k = call.fibN;
+            stack.push_back({k - 2, NodeId(call.id + 1 + shape.size[k - 1]), call.id,
+                             call.depth + 1, call.leafStart + shape.leaves[k - 1]});
+            stack.push_back({k - 1, call.id + 1, call.id, call.depth + 1, call.leafStart});
+        }
+        if (control && ++written == BuildControl::INTERVAL) {
+            control->nodesDone.fetch_add(written, std::memory_order_relaxed);
+            written = 0;
+            if (control->cancel.load(std::memory_order_relaxed)) return false;
+        }
+    }
+    if (control) control->nodesDone.fetch_add(written, std::memory_order_relaxed);
+    return true;
+}
+
+NodeId CallTree::buildNaiveFibParallel(int fibN, int threads, double vertGap, BuildControl* control) {
+    PROFILE_SCOPE("build naive parallel");
+    fibN = std::clamp(fibN, 0, ImplicitFibTree::MAX_N);
+    allocate(naiveNodeCount(fibN));
+    threads = std::max(1, threads);
+
+    // Work stealing: each worker pops the newest task of its own deque and, when that is
+    // empty, steals the oldest (largest) task of another one. A task above the cutoff writes
+    // its root, pushes the F(k-2) child for others to steal and carries on with F(k-1).
+    struct Queue { std::mutex lock; std::deque<NaiveCall> tasks; };
+    std::vector<Queue> queues(static_cast<size_t>(threads));
+    std::atomic<size_t> pending{1}; // tasks queued or running
+    std::atomic<bool> cancelled{false};
+    queues[0].tasks.push_back({fibN, 0, NO_NODE, 0, 0});
+
+    auto takeTask = [&](int self, NaiveCall& out) {
+        for (int i = 0; i < threads; ++i) {
+            Queue &q = queues[size_t((self + i) % threads)];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) continue;
+            if (i == 0) { out = q.tasks.back(); q.tasks.pop_back(); }
+            else { out = q.tasks.front(); q.tasks.pop_front(); }
+            return true;
+        }
+        return false;
+    };
+
+    const RecurrenceTables &shape = FibonacciRecurrence::TABLES;
+    auto worker = [&](int self) {
+        while (pending.load() > 0) {
+            NaiveCall call;
+            if (!takeTask(self, call)) {
+                std::this_thread::yield();
+                continue;
+            }
+            while (!cancelled.load(std::memory_order_relaxed) &&
+                   shape.size[call.fibN] > FORK_CUTOFF) {
+                writeNaiveNode(call, vertGap);
+                const int k = call.fibN;
+                NaiveCall right{k - 2, NodeId(call.id + 1 + shape.size[k - 1]), call.id,
+                                call.depth + 1, call.leafStart + shape.leaves[k - 1]};
+                pending.fetch_add(1);
+                {
+                    std::lock_guard<std::mutex> guard(queues[size_t(self)].lock);
+                    queues[size_t(self)].tasks.push_back(right);
+                }
+                call = {k - 1, call.id + 1, call.id, call.depth + 1, call.leafStart};
+                if (control) control->nodesDone.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!cancelled.load(std::memory_order_relaxed) && !fillNaiveSubtree(call, vertGap, control)) {
+                cancelled.store(true);
+            }
+            pending.fetch_sub(1);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto &t : pool) t.join();
+    return cancelled.load() ? NO_NODE : 0;
+}
+
+NodeId CallTree::buildMemoFib(int fibN, BuildControl* control) {
+    PROFILE_SCOPE("build memo");
+    // the chain of first calls F(n), F(n-1), ..., F(1) (ids 0..n-1), then F(0) under F(2),
+    // then a cached leaf F(k-2) under every F(k), k = 3..n, in that preorder
+    return FibonacciRecurrence::buildMemo(*this, fibN, control);
+}
+
+NodeId CallTree::buildNaive(RecurrenceRule rule, int n, int threads, double vertGap, BuildControl* control) {
+    if (rule == RuleFibonacci) {
+        if (n > ImplicitFibTree::MAX_N) return NO_NODE;
+        return buildNaiveFibParallel(n, threads, vertGap, control);
+    }
+    PROFILE_SCOPE("build naive");
+    return visitRecurrence(rule, [&](auto r) { return decltype(r)::buildNaive(*this, n, vertGap, control); });
+}
+
+NodeId CallTree::buildMemo(RecurrenceRule rule, int n, double vertGap, BuildControl* control) {
+    PROFILE_SCOPE("build memo");
+    const NodeId root = visitRecurrence(rule, [&](auto r) { return decltype(r)::buildMemo(*this, n, control); });
+    if (root != NO_NODE) assignPositions(vertGap);
+    return root;
+}
+
+NodeId CallTree::buildMemoDag(int fibN, BuildControl* control) {
+    if (control && control->cancel.load(std::memory_order_relaxed)) return NO_NODE;
+    // F(0) and F(1) are base cases: F(1) alone has no calls
+    allocate(fibN < 2 ? 1 : size_t(fibN) + 1);
+    setNode(0, fibN, NO_NODE);
+    if (fibN >= 2) {
+        // F(k) is first called by F(k+1); F(0) only by F(2), after F(1), which keeps ids in preorder
+        for (int k = fibN - 1; k >= 1; --k) setNode(NodeId(fibN - k), k, NodeId(fibN - k - 1));
+        setNode(NodeId(fibN), 0, NodeId(fibN - 2));
+    }
+    if (control) control->nodesDone.store(size(), std::memory_order_relaxed);
+    return 0;
+}
+
+// ---------------- layout ----------------
+// Builders store nodes in preorder: a parent precedes its children and leaves appear left
+// to right, so layout is a couple of linear scans instead of a recursion as deep as the tree.
+void CallTree::computeWidths(std::vector<double>& widths) const {
+    PROFILE_SCOPE("layout widths");
+    widths.assign(size(), 0.0);
+    for (NodeId v = NodeId(size()); v-- > 0;) {
+        if (isLeaf(v)) widths[v] = 1.0;
+        if (parent[v] != NO_NODE) widths[parent[v]] += widths[v];
+    }
+}
+
+void CallTree::assignPositions(double vertGap) {
+    PROFILE_SCOPE("layout positions");
+    double cursorX = 0.0;
+    for (NodeId v = 0; v < size(); ++v) {
+        y[v] = depth[v] * vertGap;  // pixel y
+        if (isLeaf(v)) {
+            x[v] = cursorX;         // logical coordinate
+            cursorX += 1.0;         // advance leaf slot
+        }
+    }
+    // parents centered over their outer children, children first
+    for (NodeId v = NodeId(size()); v-- > 0;) {
+        if (!isLeaf(v)) x[v] = (x[firstChild[v]] + x[lastChild(v)]) / 2.0;
+    }
+}
+
+void CallTree::collectVisitOrder(std::vector<NodeId>& order) const {
+    // the arena already is in preorder
+    order.resize(size());
+    for (NodeId v = 0; v < size(); ++v) order[v] = v;
+}
+
+// ---------------- rows by depth ----------------
+void DepthRows::build(const CallTree& tree) {
+    int maxDepth = 0;
+    for (NodeId v = 0; v < tree.size(); ++v) maxDepth = std::max(maxDepth, tree.depth[v]);
+    rows.assign(tree.empty() ? 0 : maxDepth + 1, {});
+    for (NodeId v = 0; v < tree.size(); ++v) rows[tree.depth[v]].push_back(v);
+}
+
+std::pair<size_t, size_t> DepthRows::range(const CallTree& tree, int d, double x0, double x1) const {
+    const auto &row = rows[d];
+    auto lo = std::lower_bound(row.begin(), row.end(), x0,
+                               [&tree](NodeId id, double x) { return tree.x[id] < x; });
+    auto hi = std::upper_bound(lo, row.end(), x1,
+                               [&tree](double x, NodeId id) { return x < tree.x[id]; });
+    return {size_t(lo - row.begin()), size_t(hi - row.begin())};
+}
@@ -0,0 +1,164 @@
+#ifndef CALLTREE_H
+#define CALLTREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Index of a node inside a CallTree arena
+using NodeId = std::uint32_t;
+static constexpr NodeId NO_NODE = UINT32_MAX;
+
+// Recurrences a call tree can follow, defined in recurrence.h (the order of comboRecurrence)
+enum RecurrenceRule {
+    RuleFibonacci = 0,
+    RuleTribonacci,
+    RulePadovan,
+    RuleBinomialRow,
+    RuleCount
+};
+
+// Shared with a builder running on another thread: it publishes its progress and
+// stops early once cancel is set (the partially built arena is then discarded)
+struct BuildControl {
+    static constexpr size_t INTERVAL = size_t(1) << 16; // nodes a builder writes between two looks at it
+    std::atomic<bool> cancel{false};
+    std::atomic<size_t> nodesDone{0};
+};
+
+// One array of the arena. It owns its elements, or views memory owned elsewhere
+// (a memory-mapped tree file, see treefile.h) without copying it.
+template <class T>
+class TreeColumn {
+public:
+    TreeColumn() = default;
+    TreeColumn(const TreeColumn& o) : owned(o.owned), ptr(o.isView() ? o.ptr : owned.data()), count(o.count) {}
+    TreeColumn(TreeColumn&& o) noexcept : owned(std::move(o.owned)), ptr(o.ptr), count(o.count) {
+        o.ptr = nullptr;
+        o.count = 0;
+    }
+    TreeColumn& operator=(TreeColumn o) noexcept {
+        // moving a vector keeps its buffer, so ptr stays valid
+        owned = std::move(o.owned);
+        ptr = o.ptr;
+        count = o.count;
+        o.ptr = nullptr;
+        o.count = 0;
+        return *this;
+    }
+
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+
+    // owned storage of count copies of value
+    void resize(size_t size, const T& value) {
+        owned.assign(size, value);
+        ptr = owned.data();
+        count = size;
+    }
+    // view size elements at p; the caller keeps them alive (CallTree::storage)
+    void view(T* p, size_t size) {
+        owned = std::vector<T>();
+        ptr = p;
+        count = size;
+    }
+    bool isView() const { return ptr != owned.data(); }
+
+private:
+    std::vector<T> owned;
+    T* ptr = nullptr;
+    size_t count = 0;
+};
+
+// Arena for the call tree, stored as structure-of-arrays.
+// Nodes refer to each other by 32-bit index; the whole tree is released at once by clear().
+// Values are not stored: T(n[id]) of the tree's rule is derived when shown (see fibvalues.h).
+struct CallTree {
+    TreeColumn<int> n;
+    TreeColumn<NodeId> parent;
+    TreeColumn<NodeId> firstChild;
+    TreeColumn<NodeId> nextSibling;
+    TreeColumn<int> depth;
+    TreeColumn<double> x; // logical x (units)
+    TreeColumn<double> y; // pixel y
+    TreeColumn<std::uint8_t> cached;
+    // keeps the memory the columns view alive (set by loadTreeFile, empty for built trees)
+    std::shared_ptr<void> storage;
+    RecurrenceRule rule = RuleFibonacci; // whose calls n holds; set by the builders
+
+    // bytes of one node across the columns above
+    static constexpr size_t NODE_BYTES = 2 * sizeof(int) + 3 * sizeof(NodeId) + 2 * sizeof(double) + sizeof(std::uint8_t);
+
+    size_t size() const { return n.size(); }
+    bool empty() const { return n.empty(); }
+    bool isLeaf(NodeId id) const { return firstChild[id] == NO_NODE; }
+    int childCount(NodeId id) const;
+
+    // Exact node counts of the trees produced by the builders below (table lookups for small n)
+    static size_t naiveNodeCount(int fibN);
+    static size_t memoNodeCount(int fibN);
+    static size_t naiveNodeCount(RecurrenceRule rule, int n);
+    static size_t memoNodeCount(RecurrenceRule rule, int n);
+
+    void clear();
+    // one exact allocation per array, links set to NO_NODE; nodes are then written by index.
+    // count must stay below NO_NODE.
+    void allocate(size_t count);
+
+    // Build recursion trees into an arena sized from the exact node count.
+    // Nodes are stored in preorder and the root is node 0; neither builder recurses.
+    // Both are Recurrence<FibonacciRule> (recurrence.h), whose tables give the counts below.
+    // Returns NO_NODE when cancelled through control.
+    NodeId buildNaiveFib(int fibN, BuildControl* control = nullptr);
+    NodeId buildMemoFib(int fibN, BuildControl* control = nullptr);
+    // F(n), F(n-1), ..., F(0) once each, every node under its first caller; the memo-table
+    // hits are the extra edges of MemoDag (memodag.h). Not laid out: see MemoDag::layout.
+    NodeId buildMemoDag(int fibN, BuildControl* control = nullptr);
+
+    // Naive tree built by `threads` workers, laid out as it is built (no assignPositions needed).
+    // Subtree sizes and leaf counts are known in closed form, so every forked subtree has a fixed
+    // preorder range and leaf-slot range; workers write straight into those ranges of the arena.
+    NodeId buildNaiveFibParallel(int fibN, int threads, double vertGap, BuildControl* control = nullptr);
+
+    // Trees of any rule, laid out: Fibonacci through the parallel builder above, the other
+    // rules through their Recurrence on the calling thread. NO_NODE past the rule's MAX_N.
+    NodeId buildNaive(RecurrenceRule rule, int n, int threads, double vertGap, BuildControl* control = nullptr);
+    NodeId buildMemo(RecurrenceRule rule, int n, double vertGap, BuildControl* control = nullptr);
+
+    // Layout, as linear scans over the preorder arena
+    void computeWidths(std::vector<double>& widths) const;
+    void assignPositions(double vertGap);
+
+    void collectVisitOrder(std::vector<NodeId>& order) const;
+
+private:
+    // Fill node id and link it as the last child of p (NO_NODE for the root)
+    void setNode(NodeId id, int fibN, NodeId p);
+    NodeId lastChild(NodeId id) const;
+
+    struct NaiveCall { int fibN; NodeId id; NodeId parent; int depth; std::uint64_t leafStart; };
+    // Write the whole subtree of call into its preorder range; false when cancelled
+    bool fillNaiveSubtree(const NaiveCall& call, double vertGap, BuildControl* control);
+    void writeNaiveNode(const NaiveCall& call, double vertGap);
+};
+
+// Nodes grouped by depth, each row sorted by x (preorder already visits every depth left to right)
+struct DepthRows {
+    std::vector<std::vector<NodeId>> rows;
+
+    void build(const CallTree& tree);
+    void clear() { rows.clear(); }
+    // [first, last) indices into rows[d] of the nodes whose logical x lies in [x0, x1]
+    std::pair<size_t, size_t> range(const CallTree& tree, int d, double x0, double x1) const;
+};
+
+#endif // CALLTREE_H
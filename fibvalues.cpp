@@ -0,0 +1,36 @@
+#include "fibvalues.h"
+#include "recurrence.h"
+#include <vector>
+
+static const size_t LABEL_DIGITS = 16; // about what fits under a node at full zoom
+static const int LABEL_EDGE = 6;
+
+BigUInt fibValue(int k) {
+    // machine words straight from the compile-time table
+    if (k <= FibonacciRecurrence::MAX_N) return BigUInt(FibonacciRecurrence::value(k));
+    return fibFastDoubling(uint64_t(k));
+}
+
+BigUInt recurrenceValue(RecurrenceRule rule, int k) {
+    if (rule == RuleFibonacci) return fibValue(k);
+    return visitRecurrence(rule, [k](auto r) { return BigUInt(decltype(r)::value(k)); });
+}
+
+std::string valueLabel(RecurrenceRule rule, int k) {
+    static std::vector<std::string> labels[RuleCount]; // indexed by k, empty until first asked for
+    std::vector<std::string> &cache = labels[rule];
+    if (cache.size() <= size_t(k)) cache.resize(size_t(k) + 1);
+    std::string &label = cache[size_t(k)];
+    if (label.empty()) {
+        BigUInt v = recurrenceValue(rule, k);
+        if (v.decimalDigits() <= LABEL_DIGITS) label = v.toString();
+        else label = v.leadingDigits(LABEL_EDGE) + "..." + v.trailingDigits(LABEL_EDGE);
+    }
+    return label;
+}
+
+std::string valueText(RecurrenceRule rule, int k, size_t maxDigits) {
+    BigUInt v = recurrenceValue(rule, k);
+    if (v.decimalDigits() <= maxDigits) return v.toString();
+    return v.summary();
+}
@@ -0,0 +1,25 @@
+#ifndef FIBVALUES_H
+#define FIBVALUES_H
+
+#include <cstddef>
+#include <string>
+#include "bigint.h"
+#include "calltree.h"
+
+// Values of F(k), and of T(k) for the other recurrences, for node labels and the info panel.
+// Nodes only store k; the value is computed the first time something shows it (a table lookup
+// up to the rule's MAX_N, fast doubling above it for Fibonacci).
+
+BigUInt fibValue(int k);
+// T(k) of a rule; rules other than Fibonacci have values up to their MAX_N (recurrence.h)
+BigUInt recurrenceValue(RecurrenceRule rule, int k);
+
+// Short text for a node label: the full value, or "leading...trailing" once it no longer fits.
+// Cached per rule and k, since a tree repeats the same few k over and over; returned by value
+// because a later k grows the cache. The cache is unsynchronized: GUI thread only.
+std::string valueLabel(RecurrenceRule rule, int k);
+
+// Full decimal value when it has at most maxDigits digits, a summary otherwise
+std::string valueText(RecurrenceRule rule, int k, size_t maxDigits = 2000);
+
+#endif // FIBVALUES_H
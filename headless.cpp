@@ -0,0 +1,325 @@
+#include "headless.h"
+#include "allocstats.h"
+#include "calltree.h"
+#include "implicittree.h"
+#include "implicittreeview.h"
+#include "nodeitem.h"
+#include "profiler.h"
+#include "treescene.h"
+#include "virtualscene.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QImage>
+#include <QMap>
+#include <QPainter>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+
+// naive trees beyond this need several GB
+static const int MAX_HEADLESS_NAIVE = 32;
+// a phase only counts as regressed when it is this much slower in absolute terms too
+static const double REGRESSION_MIN_MS = 1.0;
+
+enum Phase { PhaseBuild = 0, PhaseLayout, PhaseDraw, PhaseReveal, PhaseRender, PhaseCount };
+static const char* const PHASE_NAMES[PhaseCount] = {"build", "layout", "draw", "reveal", "render"};
+
+struct HeadlessOptions {
+    bool naive = true;
+    QString renderer = "batched"; // items | virtual | batched | implicit
+    std::vector<int> ns;
+    int threads = 1;              // 0: serial builder followed by computeWidths/assignPositions
+    int repeat = 3;
+    bool render = false;
+    QString savePattern;          // %1 is replaced by n
+    QSize size = QSize(1600, 1000);
+    QString csvPath;
+    QString baselinePath;
+    double tolerance = 0.25;
+};
+
+struct RunResult {
+    int n = 0;
+    size_t nodes = 0;
+    double ms[PhaseCount] = {};
+    AllocStats alloc[PhaseCount];
+    size_t peakRssBytes = 0; // of the process once this run is done; it never goes down
+};
+
+static QString imagePath(const QString& pattern, int n) {
+    return pattern.contains("%1") ? pattern.arg(n) : pattern;
+}
+
+template <class F>
+static void measure(RunResult& r, Phase phase, F&& work) {
+    AllocStats before = AllocStats::now();
+    QElapsedTimer timer;
+    timer.start();
+    work();
+    r.ms[phase] = timer.nsecsElapsed() / 1e6;
+    r.alloc[phase] = AllocStats::now() - before;
+}
+
+// ---------------- one pass of the pipeline ----------------
+static RunResult runOnce(const HeadlessOptions& opt, int n, bool save) {
+    RunResult r;
+    r.n = n;
+    QImage image(opt.size, QImage::Format_ARGB32_Premultiplied);
+
+    if (opt.renderer == "implicit") {
+        // nothing is built: the view derives every node from its preorder index
+        ImplicitTreeView view;
+        view.resize(opt.size);
+        measure(r, PhaseDraw, [&] { view.setTree(n); });
+        r.nodes = view.tree().nodeCount();
+        measure(r, PhaseReveal, [&] { view.setRevealedCount(view.tree().nodeCount()); });
+        if (opt.render) {
+            measure(r, PhaseRender, [&] {
+                image.fill(Qt::white);
+                QPainter painter(&image);
+                view.render(&painter);
+            });
+        }
+        if (save) image.save(imagePath(opt.savePattern, n));
+        return r;
+    }
+
+    CallTree tree;
+    measure(r, PhaseBuild, [&] {
+        if (!opt.naive) tree.buildMemoFib(n);
+        else if (opt.threads > 0) tree.buildNaiveFibParallel(n, opt.threads, V_GAP);
+        else tree.buildNaiveFib(n);
+    });
+    r.nodes = tree.size();
+    // the parallel naive builder already placed every node
+    if (!opt.naive || opt.threads == 0) {
+        measure(r, PhaseLayout, [&] {
+            std::vector<double> widths;
+            tree.computeWidths(widths);
+            tree.assignPositions(V_GAP);
+        });
+    }
+
+    QGraphicsScene scene;
+    QGraphicsView view(&scene);
+    view.setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    view.setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    view.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+    view.resize(opt.size);
+    view.show(); // offscreen: lays out the viewport without a window
+    VirtualTreeScene virtualScene(&scene, &view);
+    TreeScene treeScene(&scene, &virtualScene);
+    const RenderMode mode = opt.renderer == "virtual" ? RenderVirtualized
+                          : opt.renderer == "batched" ? RenderBatched : RenderItems;
+
+    // as MainWindow::drawTree and finishDraw, with the items populated in one go
+    measure(r, PhaseDraw, [&] {
+        treeScene.setTree(&tree, mode, nullptr, nullptr);
+        treeScene.populate(-1);
+        treeScene.startReveal(SchedulePreorder);
+        view.fitInView(treeScene.bounds(), Qt::KeepAspectRatio);
+        if (mode == RenderVirtualized) virtualScene.refresh();
+    });
+
+    // as Skip once it runs out of time: one seek to the end of the timeline
+    measure(r, PhaseReveal, [&] { treeScene.seek(treeScene.timeline().length()); });
+
+    if (opt.render) {
+        measure(r, PhaseRender, [&] {
+            image.fill(Qt::white);
+            QPainter painter(&image);
+            view.render(&painter);
+        });
+    }
+    if (save) image.save(imagePath(opt.savePattern, n));
+    treeScene.clear();
+    return r;
+}
+
+// ---------------- argument parsing ----------------
+static bool parseNs(const QString& text, std::vector<int>& out) {
+    // "10,15,20" or "10-20" or "10-20:2"
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        QString range = part.section(':', 0, 0);
+        int step = part.contains(':') ? part.section(':', 1, 1).toInt() : 1;
+        bool ok1 = false, ok2 = true;
+        int from = range.section('-', 0, 0).toInt(&ok1);
+        int to = range.contains('-') ? range.section('-', 1, 1).toInt(&ok2) : from;
+        if (!ok1 || !ok2 || step <= 0 || from < 0 || to < from) return false;
+        for (int n = from; n <= to; n += step) out.push_back(n);
+    }
+    return !out.empty();
+}
+
+static QString csvHeader() {
+    QString s = "n,nodes";
+    for (const char* name : PHASE_NAMES) s += QString(",%1_ms,%1_allocs").arg(name);
+    return s + ",peak_rss_mb";
+}
+
+static QMap<int, QStringList> readBaseline(const QString& path) {
+    QMap<int, QStringList> rows;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return rows;
+    QTextStream in(&file);
+    in.readLine(); // header
+    while (!in.atEnd()) {
+        QStringList cols = in.readLine().split(',');
+        if (cols.size() > 1) rows.insert(cols[0].toInt(), cols);
+    }
+    return rows;
+}
+
+int runHeadless(const QStringList& arguments) {
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless pipeline benchmark for the Fibonacci call tree");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"headless", "Run without a window (this mode)."},
+        {"mode", "naive or memo.", "mode", "naive"},
+        {"renderer", "items, virtual, batched or implicit.", "renderer", "batched"},
+        {"n", "Values of n: list and/or ranges, e.g. 10,12 or 10-25:3.", "list"},
+        {"threads", "Naive build workers; 0 = serial builder plus separate layout.", "count",
+         QString::number(std::max(1, QThread::idealThreadCount()))},
+        {"repeat", "Runs per n; the fastest time of each phase is reported.", "count", "3"},
+        {"render", "Also time rendering the fitted view into a QImage."},
+        {"save", "Save the rendered image; %1 in the path is replaced by n (implies --render).", "path"},
+        {"size", "Image size WxH.", "size", "1600x1000"},
+        {"csv", "Write results as CSV.", "file"},
+        {"baseline", "Compare phase times with a CSV written by --csv; exit code 1 on regression.", "file"},
+        {"tolerance", "Allowed slowdown against the baseline (0.25 = 25%).", "fraction", "0.25"},
+        {"trace", "Record the profiler and write a Chrome trace-event JSON file.", "file"},
+    });
+    if (!parser.parse(arguments)) {
+        err << parser.errorText() << "\n";
+        return 2;
+    }
+    if (parser.isSet("help")) {
+        out << parser.helpText();
+        return 0;
+    }
+
+    HeadlessOptions opt;
+    opt.naive = parser.value("mode") != "memo";
+    opt.renderer = parser.value("renderer");
+    opt.threads = std::max(0, parser.value("threads").toInt());
+    opt.repeat = std::max(1, parser.value("repeat").toInt());
+    opt.savePattern = parser.value("save");
+    opt.render = parser.isSet("render") || !opt.savePattern.isEmpty();
+    opt.csvPath = parser.value("csv");
+    opt.baselinePath = parser.value("baseline");
+    opt.tolerance = parser.value("tolerance").toDouble();
+    QStringList wh = parser.value("size").split('x');
+    if (wh.size() == 2) opt.size = QSize(std::max(64, wh[0].toInt()), std::max(64, wh[1].toInt()));
+
+    const QStringList renderers = {"items", "virtual", "batched", "implicit"};
+    if (!renderers.contains(opt.renderer) || (opt.renderer == "implicit" && !opt.naive)) {
+        err << "Unknown renderer (the implicit renderer only draws naive trees)\n";
+        return 2;
+    }
+    QString nText = parser.value("n");
+    if (nText.isEmpty()) nText = opt.naive ? "15-27:3" : "1000,10000,100000";
+    if (!parseNs(nText, opt.ns)) {
+        err << "Bad --n list: " << nText << "\n";
+        return 2;
+    }
+    const int maxN = opt.renderer == "implicit" ? ImplicitFibTree::MAX_N : opt.naive ? MAX_HEADLESS_NAIVE : 10000000;
+
+    out << QString("%1 tree, %2 renderer, %3 threads, best of %4\n")
+           .arg(QString(opt.naive ? "naive" : "memo"), opt.renderer).arg(opt.threads).arg(opt.repeat);
+    out << QString("%1 %2").arg("n", 6).arg("nodes", 12);
+    for (const char* name : PHASE_NAMES) out << QString(" %1").arg(QString(name) + " ms", 12);
+    out << QString(" %1 %2\n").arg("allocs", 10).arg("peak MB", 9);
+
+    const QString tracePath = parser.value("trace");
+    if (!tracePath.isEmpty()) Profiler::setEnabled(true);
+
+    std::vector<RunResult> results;
+    for (int n : opt.ns) {
+        if (n > maxN) {
+            err << "skipping n = " << n << " (above " << maxN << " for this configuration)\n";
+            continue;
+        }
+        RunResult best;
+        for (int rep = 0; rep < opt.repeat; ++rep) {
+            RunResult r = runOnce(opt, n, rep == opt.repeat - 1 && !opt.savePattern.isEmpty());
+            r.peakRssBytes = AllocStats::peakRssBytes();
+            if (rep == 0) {
+                best = r;
+            } else {
+                for (int p = 0; p < PhaseCount; ++p) best.ms[p] = std::min(best.ms[p], r.ms[p]);
+                best.peakRssBytes = r.peakRssBytes;
+            }
+        }
+        results.push_back(best);
+
+        uint64_t allocs = 0;
+        for (const AllocStats &a : best.alloc) allocs += a.allocations;
+        out << QString("%1 %2").arg(best.n, 6).arg(qulonglong(best.nodes), 12);
+        for (double ms : best.ms) out << QString(" %1").arg(ms, 12, 'f', 2);
+        // the window target is built without the heap counters
+        const QString allocText = AllocStats::counting() ? QString::number(qulonglong(allocs)) : QString("n/a");
+        out << QString(" %1 %2\n").arg(allocText, 10).arg(best.peakRssBytes / 1048576.0, 9, 'f', 1);
+        out.flush();
+    }
+
+    if (!tracePath.isEmpty()) {
+        Profiler::setEnabled(false);
+        out << "\n" << QString::fromStdString(Profiler::summary());
+        const std::string json = Profiler::chromeTrace();
+        QSaveFile file(tracePath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(json.data(), qint64(json.size())) != qint64(json.size())
+            || !file.commit()) {
+            err << "Cannot write " << tracePath << ": " << file.errorString() << "\n";
+            return 2;
+        }
+    }
+
+    if (!opt.csvPath.isEmpty()) {
+        QFile file(opt.csvPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            err << "Cannot write " << opt.csvPath << "\n";
+            return 2;
+        }
+        QTextStream csv(&file);
+        csv << csvHeader() << "\n";
+        for (const RunResult &r : results) {
+            csv << r.n << "," << qulonglong(r.nodes);
+            for (int p = 0; p < PhaseCount; ++p) csv << "," << QString::number(r.ms[p], 'f', 3) << "," << r.alloc[p].allocations;
+            csv << "," << QString::number(r.peakRssBytes / 1048576.0, 'f', 1) << "\n";
+        }
+    }
+
+    int exitCode = 0;
+    if (!opt.baselinePath.isEmpty()) {
+        QMap<int, QStringList> base = readBaseline(opt.baselinePath);
+        if (base.isEmpty()) {
+            err << "Baseline " << opt.baselinePath << " is missing or empty\n";
+            return 2;
+        }
+        for (const RunResult &r : results) {
+            if (!base.contains(r.n)) continue;
+            const QStringList &cols = base[r.n];
+            for (int p = 0; p < PhaseCount; ++p) {
+                int col = 2 + 2 * p; // n, nodes, then (ms, allocs) per phase
+                if (col >= cols.size()) break;
+                double before = cols[col].toDouble();
+                if (r.ms[p] > before * (1.0 + opt.tolerance) && r.ms[p] - before > REGRESSION_MIN_MS) {
+                    out << QString("REGRESSION n=%1 %2: %3 ms -> %4 ms\n")
+                           .arg(r.n).arg(QString(PHASE_NAMES[p])).arg(before, 0, 'f', 2).arg(r.ms[p], 0, 'f', 2);
+                    exitCode = 1;
+                }
+            }
+        }
+        if (exitCode == 0) out << "No regressions against " << opt.baselinePath << "\n";
+    }
+    return exitCode;
+}
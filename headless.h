@@ -0,0 +1,13 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QStringList>
+
+// Runs the Draw pipeline without a window over a sweep of n: build, layout, scene population
+// and full reveal, optionally rendering the result to an image. Prints wall time and heap
+// allocations per phase plus peak RSS, and can write CSV and compare against a baseline CSV.
+// Needs a QApplication (the offscreen platform is enough). Returns the process exit code,
+// non-zero on bad arguments or when a phase regressed against the baseline.
+int runHeadless(const QStringList& arguments);
+
+#endif // HEADLESS_H
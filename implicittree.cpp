@@ -0,0 +1,98 @@
+#include "implicittree.h"
+#include "recurrence.h"
+#include <algorithm>
+
+// ---------------- closed-form tables ----------------
+// lookups into the recurrence engine's compile-time tables
+static_assert(FibonacciRecurrence::MAX_N > ImplicitFibTree::MAX_N, "subtreeSize(MAX_N) must be in the tables");
+
+ImplicitFibTree::ImplicitFibTree(int n) : rootFib(std::clamp(n, 0, MAX_N)) {}
+
+uint64_t ImplicitFibTree::fib(int k) { return FibonacciRecurrence::value(k); }
+uint64_t ImplicitFibTree::subtreeSize(int k) { return FibonacciRecurrence::subtreeSize(k); }
+uint64_t ImplicitFibTree::subtreeLeaves(int k) { return FibonacciRecurrence::subtreeLeaves(k); }
+double ImplicitFibTree::relativeX(int k) { return FibonacciRecurrence::relativeX(k); }
+
+// ---------------- navigation ----------------
+ImplicitFibTree::Node ImplicitFibTree::root() const {
+    Node node;
+    node.n = rootFib;
+    return node;
+}
+
+ImplicitFibTree::Node ImplicitFibTree::child(const Node& node, int which) const {
+    Node c;
+    c.depth = node.depth + 1;
+    c.parent = node.index;
+    c.parentLeafStart = node.leafStart;
+    c.parentN = node.n;
+    if (which == 0) {
+        c.n = node.n - 1;
+        c.index = node.index + 1;
+        c.leafStart = node.leafStart;
+    } else {
+        c.n = node.n - 2;
+        c.index = node.index + 1 + subtreeSize(node.n - 1);
+        c.leafStart = node.leafStart + subtreeLeaves(node.n - 1);
+    }
+    return c;
+}
+
+ImplicitFibTree::Node ImplicitFibTree::at(uint64_t index) const {
+    Node node = root();
+    if (index >= nodeCount()) return node;
+    while (node.index != index) {
+        // preorder: the F(n-1) subtree occupies the next subtreeSize(n-1) indices
+        uint64_t rel = index - node.index - 1;
+        node = child(node, rel < subtreeSize(node.n - 1) ? 0 : 1);
+    }
+    return node;
+}
+
+ImplicitFibTree::Node ImplicitFibTree::fromPath(const std::vector<int>& path) const {
+    Node node = root();
+    for (int step : path) {
+        if (node.isLeaf()) break;
+        node = child(node, step ? 1 : 0);
+    }
+    return node;
+}
+
+std::vector<int> ImplicitFibTree::pathOf(uint64_t index) const {
+    std::vector<int> path;
+    Node node = root();
+    if (index >= nodeCount()) return path;
+    while (node.index != index) {
+        int which = index - node.index - 1 < subtreeSize(node.n - 1) ? 0 : 1;
+        path.push_back(which);
+        node = child(node, which);
+    }
+    return path;
+}
+
+// ---------------- occurrences ----------------
+uint64_t ImplicitFibTree::occurrences(int m, int k) {
+    if (k < 0 || m < k) return 0;
+    if (m == k) return 1;
+    // F(m) calls F(m-1) and F(m-2): F(m-k+1) calls of F(k) for k >= 1, F(m-1) of F(0)
+    if (k == 0) return m >= 2 ? fib(m - 1) : 0;
+    return fib(m - k + 1);
+}
+
+uint64_t ImplicitFibTree::occurrence(int k, uint64_t i) const {
+    if (i >= occurrences(rootFib, k)) return NO_INDEX;
+    uint64_t index = 0;
+    int m = rootFib;
+    while (m != k) {
+        uint64_t first = occurrences(m - 1, k);
+        if (i < first) {
+            index += 1;
+            m -= 1;
+        } else {
+            i -= first;
+            index += 1 + subtreeSize(m - 1);
+            m -= 2;
+        }
+    }
+    return index;
+}
@@ -0,0 +1,79 @@
+#ifndef IMPLICITTREE_H
+#define IMPLICITTREE_H
+
+#include <cstdint>
+#include <vector>
+
+// Naive recursion tree of F(n) that is never materialized.
+// The subtree of F(k) has exactly 2*F(k+1)-1 nodes and F(k+1) leaves, so every node,
+// addressed by its preorder index or its path from the root, is found in O(depth)
+// arithmetic with the same leaf-slot layout CallTree::assignPositions produces.
+class ImplicitFibTree {
+public:
+    static constexpr int MAX_N = 90;          // 2*F(91)-1 still fits in 64 bits
+    static constexpr uint64_t NO_INDEX = UINT64_MAX;
+
+    struct Node {
+        uint64_t index = 0;        // preorder index
+        int n = 0;                 // this call computes F(n)
+        int depth = 0;
+        uint64_t leafStart = 0;    // first leaf slot covered by the subtree
+        uint64_t parent = NO_INDEX;
+        uint64_t parentLeafStart = 0;
+        int parentN = -1;
+
+        // layout x (logical units) = leafStart + relativeX(n); split so huge trees keep precision
+        double xOffset() const { return relativeX(n); }
+        double parentXOffset() const { return parentN < 0 ? 0.0 : relativeX(parentN); }
+        uint64_t value() const { return fib(n); }
+        bool isLeaf() const { return n <= 1; }
+    };
+
+    explicit ImplicitFibTree(int n = 0);
+
+    int rootN() const { return rootFib; }
+    uint64_t nodeCount() const { return subtreeSize(rootFib); }
+    uint64_t leafCount() const { return subtreeLeaves(rootFib); }
+
+    static uint64_t fib(int k);
+    static uint64_t subtreeSize(int k);   // 2*F(k+1) - 1
+    static uint64_t subtreeLeaves(int k); // F(k+1)
+    static double relativeX(int k);       // x of F(k) relative to its first leaf slot
+
+    Node root() const;
+    Node child(const Node& node, int which) const; // 0 -> F(n-1), 1 -> F(n-2)
+    Node at(uint64_t index) const;
+    Node fromPath(const std::vector<int>& path) const;
+    std::vector<int> pathOf(uint64_t index) const;
+
+    // Calls of F(k) inside the subtree of F(m), and the preorder index of the i-th (0-based)
+    // call of F(k) in the whole tree, found in O(depth); NO_INDEX when there are fewer
+    static uint64_t occurrences(int m, int k);
+    uint64_t occurrence(int k, uint64_t i) const;
+
+    // Visit (node, collapsed) for every node with depth <= maxDepth whose subtree overlaps
+    // leaf slots [slot0, slot1]. Subtrees spanning fewer than minSlots leaves are reported
+    // once with collapsed = true and not descended, which bounds the work by screen size.
+    // The visitor returns false to skip the node's descendants.
+    template <class Visit>
+    void visitWindow(uint64_t slot0, uint64_t slot1, int maxDepth, double minSlots, Visit&& visit) const {
+        Node stack[MAX_N + 2];
+        int top = 0;
+        stack[top++] = root();
+        while (top > 0) {
+            Node node = stack[--top];
+            uint64_t lastSlot = node.leafStart + subtreeLeaves(node.n) - 1;
+            if (lastSlot < slot0 || node.leafStart > slot1) continue;
+            bool collapsed = !node.isLeaf() && double(subtreeLeaves(node.n)) < minSlots;
+            if (!visit(node, collapsed)) continue;
+            if (node.isLeaf() || collapsed || node.depth >= maxDepth) continue;
+            stack[top++] = child(node, 1);
+            stack[top++] = child(node, 0);
+        }
+    }
+
+private:
+    int rootFib = 0;
+};
+
+#endif // IMPLICITTREE_H
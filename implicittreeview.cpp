@@ -0,0 +1,268 @@
+#include "implicittreeview.h"
+#include "nodeitem.h"
+#include "nodelabels.h"
+#include "profiler.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QResizeEvent>
+#include <QLinearGradient>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const double MIN_SUBTREE_PX = 3.0; // narrower subtrees are drawn as one band
+static const double LOD_ELLIPSE = 0.25;   // node scale above which nodes are ellipses, not dots
+static const double LOD_LABELS = 0.45;    // ... and get labels
+
+ImplicitTreeView::ImplicitTreeView(QWidget* parent) : QWidget(parent) {
+    setMouseTracking(false);
+    setMinimumSize(400, 360);
+    setCursor(Qt::OpenHandCursor);
+}
+
+void ImplicitTreeView::setTree(int n) {
+    fibTree = ImplicitFibTree(n);
+    revealCount = 0;
+    selected = ImplicitFibTree::NO_INDEX;
+    autoFit = true;
+    fitAll();
+}
+
+void ImplicitTreeView::setRevealedCount(uint64_t count) {
+    revealCount = std::min(count, fibTree.nodeCount());
+    update();
+}
+
+void ImplicitTreeView::setSelected(uint64_t index) {
+    selected = index;
+    update();
+}
+
+// ---------------- camera ----------------
+double ImplicitTreeView::screenX(uint64_t slot, double offset) const {
+    // integer part first, so the subtraction is exact however large the tree is
+    return (double(int64_t(slot) - originSlot) + offset - originFrac) * slotPx;
+}
+
+double ImplicitTreeView::nodeScale() const {
+    return std::min(slotPx / H_GAP, rowPx / V_GAP);
+}
+
+void ImplicitTreeView::panSlots(double delta) {
+    double total = originFrac + delta;
+    double shift = std::floor(total);
+    originFrac = total - shift;
+    originSlot += int64_t(shift);
+    clampCamera();
+}
+
+void ImplicitTreeView::clampCamera() {
+    // keep origin within a quarter tree of the edges so slot differences stay in int64 range
+    const int64_t leaves = int64_t(fibTree.leafCount());
+    const int64_t margin = std::max<int64_t>(leaves / 4, 1024);
+    if (originSlot < -margin) { originSlot = -margin; originFrac = 0.0; }
+    if (originSlot > leaves) { originSlot = leaves; originFrac = 0.0; }
+    const double maxY = fibTree.rootN() * rowPx;
+    offsetY = std::clamp(offsetY, -height() / 2.0, std::max(0.0, maxY - height() / 2.0));
+}
+
+void ImplicitTreeView::fitAll() {
+    const double leaves = double(fibTree.leafCount());
+    const int levels = std::max(1, fibTree.rootN());
+    fitSlotPx = std::min(H_GAP, std::max(50.0, width() - 2 * NODE_HALF_W) / leaves);
+    fitRowPx = std::max(1.0, std::min(V_GAP, std::max(50.0, height() - 2 * NODE_HALF_H) / levels));
+    slotPx = fitSlotPx;
+    rowPx = fitRowPx;
+    offsetY = -NODE_HALF_H * nodeScale() - 4;
+    // center the tree horizontally
+    originSlot = 0;
+    originFrac = 0.0;
+    panSlots(((leaves - 1) * slotPx - width()) / 2.0 / slotPx);
+    update();
+}
+
+void ImplicitTreeView::centerOn(uint64_t index) {
+    ImplicitFibTree::Node node = fibTree.at(index);
+    double total = node.xOffset() - width() / 2.0 / slotPx;
+    double shift = std::floor(total);
+    originSlot = int64_t(node.leafStart) + int64_t(shift);
+    originFrac = total - shift;
+    offsetY = node.depth * rowPx - height() / 2.0;
+    autoFit = false;
+    clampCamera();
+    update();
+}
+
+// ---------------- visible window ----------------
+template <class Visit>
+void ImplicitTreeView::visitVisible(Visit&& visit) const {
+    const int64_t leaves = int64_t(fibTree.leafCount());
+    const double margin = NODE_HALF_W * nodeScale() / slotPx + 1.0; // in slots
+    // slot positions relative to originSlot; clamp in double first so int64 conversion cannot overflow
+    auto toSlot = [&](double rel) {
+        rel = std::min(std::max(rel, double(-originSlot)), double(leaves - 1 - originSlot));
+        return uint64_t(std::clamp<int64_t>(originSlot + int64_t(std::floor(rel)), 0, leaves - 1));
+    };
+    uint64_t slot0 = toSlot(originFrac - margin);
+    uint64_t slot1 = toSlot(std::ceil(originFrac + width() / slotPx + margin));
+    int maxDepth = int(std::floor((height() + offsetY) / rowPx)) + 1;
+    fibTree.visitWindow(slot0, slot1, std::min(maxDepth, fibTree.rootN()), MIN_SUBTREE_PX / slotPx,
+                        std::forward<Visit>(visit));
+}
+
+// ---------------- paint ----------------
+void ImplicitTreeView::paintEvent(QPaintEvent*) {
+    PROFILE_SCOPE("paint implicit");
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    painter.setRenderHint(QPainter::Antialiasing);
+    if (revealCount == 0) return;
+
+    const double scale = nodeScale();
+    const double bottom = height() + NODE_HALF_H * scale;
+    std::vector<QLineF> edges;
+    std::vector<QRectF> bands;
+    std::vector<ImplicitFibTree::Node> nodes;
+
+    visitVisible([&](const ImplicitFibTree::Node& node, bool collapsed) {
+        // preorder: an unrevealed node has only unrevealed descendants
+        if (node.index >= revealCount) return false;
+        const double x = screenX(node.leafStart, node.xOffset());
+        const double y = screenY(node.depth);
+        if (node.parent != ImplicitFibTree::NO_INDEX) {
+            edges.emplace_back(screenX(node.parentLeafStart, node.parentXOffset()), screenY(node.depth - 1), x, y);
+        }
+        if (collapsed) {
+            // the whole subtree is narrower than a few pixels: draw its footprint
+            // (as soon as its root is revealed, partially revealed subtrees included)
+            double left = screenX(node.leafStart, 0.0);
+            double right = screenX(node.leafStart + ImplicitFibTree::subtreeLeaves(node.n) - 1, 0.0);
+            bands.emplace_back(QPointF(left, y), QPointF(std::max(right, left + 1.0), screenY(node.depth + node.n - 1)));
+        }
+        if (y > -NODE_HALF_H * scale && y < bottom) nodes.push_back(node);
+        return y < bottom;
+    });
+
+    painter.setPen(QPen(QColor(0, 0, 0), 1));
+    painter.drawLines(edges.data(), int(edges.size()));
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(20, 184, 166, 90));
+    for (const QRectF &band : bands) painter.drawRect(band);
+
+    if (scale < LOD_ELLIPSE) {
+        QPen dotPen(QColor(20, 184, 166), std::max(2.0, 2 * NODE_HALF_H * scale));
+        dotPen.setCapStyle(Qt::RoundCap);
+        painter.setPen(dotPen);
+        for (const auto &node : nodes) {
+            if (node.index == selected) continue;
+            painter.drawPoint(QPointF(screenX(node.leafStart, node.xOffset()), screenY(node.depth)));
+        }
+    } else {
+        QLinearGradient normal(0, 0, 1, 1);
+        normal.setCoordinateMode(QGradient::ObjectBoundingMode);
+        normal.setColorAt(0.0, QColor(51, 65, 151));
+        normal.setColorAt(1.0, QColor(20, 184, 166));
+        painter.setPen(QPen(QColor(240, 244, 249), 1));
+        painter.setBrush(normal);
+        const double hw = NODE_HALF_W * scale, hh = NODE_HALF_H * scale;
+        for (const auto &node : nodes) {
+            QPointF c(screenX(node.leafStart, node.xOffset()), screenY(node.depth));
+            painter.drawEllipse(c, hw, hh);
+        }
+        if (scale >= LOD_LABELS) {
+            // the shared captions are laid out at node size; each node scales them into place
+            const QRectF r(-NODE_HALF_W, -NODE_HALF_H, 2 * NODE_HALF_W, 2 * NODE_HALF_H);
+            for (const auto &node : nodes) {
+                painter.setTransform(QTransform(scale, 0, 0, scale, screenX(node.leafStart, node.xOffset()), screenY(node.depth)));
+                drawNodeLabels(&painter, r, RuleFibonacci, node.n);
+            }
+            painter.resetTransform();
+        }
+    }
+
+    if (selected < revealCount) {
+        ImplicitFibTree::Node node = fibTree.at(selected);
+        QPointF c(screenX(node.leafStart, node.xOffset()), screenY(node.depth));
+        QLinearGradient warm(0, 0, 1, 1);
+        warm.setCoordinateMode(QGradient::ObjectBoundingMode);
+        warm.setColorAt(0.0, QColor(255, 94, 98));
+        warm.setColorAt(1.0, QColor(255, 159, 67));
+        painter.setPen(QPen(QColor(240, 244, 249), 1));
+        painter.setBrush(warm);
+        painter.drawEllipse(c, std::max(4.0, NODE_HALF_W * scale), std::max(4.0, NODE_HALF_H * scale));
+    }
+}
+
+// ---------------- interaction ----------------
+uint64_t ImplicitTreeView::hitTest(const QPointF& pos) const {
+    const double scale = nodeScale();
+    const double rx = std::max(4.0, NODE_HALF_W * scale), ry = std::max(4.0, NODE_HALF_H * scale);
+    uint64_t hit = ImplicitFibTree::NO_INDEX;
+    visitVisible([&](const ImplicitFibTree::Node& node, bool) {
+        if (node.index >= revealCount) return false;
+        double dx = (pos.x() - screenX(node.leafStart, node.xOffset())) / rx;
+        double dy = (pos.y() - screenY(node.depth)) / ry;
+        if (dx * dx + dy * dy <= 1.0) hit = node.index;
+        return true;
+    });
+    return hit;
+}
+
+void ImplicitTreeView::wheelEvent(QWheelEvent* event) {
+    int steps = event->angleDelta().y() / 120;
+    if (steps == 0) return;
+    const double factor = std::pow(1.125, steps);
+    const QPointF at = event->position();
+    autoFit = false;
+
+    // keep the point under the cursor fixed
+    double slotUnderCursor = originFrac + at.x() / slotPx;
+    double rowUnderCursor = (at.y() + offsetY) / rowPx;
+    slotPx = std::clamp(slotPx * factor, fitSlotPx, 4 * H_GAP);
+    rowPx = std::clamp(rowPx * factor, std::min(fitRowPx, V_GAP), 4 * V_GAP);
+    originFrac = 0.0;
+    panSlots(slotUnderCursor - at.x() / slotPx);
+    offsetY = rowUnderCursor * rowPx - at.y();
+    clampCamera();
+    update();
+    event->accept();
+}
+
+void ImplicitTreeView::mousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) return;
+    dragging = true;
+    lastDrag = pressPos = event->position().toPoint();
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void ImplicitTreeView::mouseMoveEvent(QMouseEvent* event) {
+    if (!dragging) return;
+    QPoint p = event->position().toPoint();
+    QPoint delta = p - lastDrag;
+    lastDrag = p;
+    autoFit = false;
+    panSlots(-delta.x() / slotPx);
+    offsetY -= delta.y();
+    clampCamera();
+    update();
+}
+
+void ImplicitTreeView::resizeEvent(QResizeEvent*) {
+    if (autoFit) fitAll();
+}
+
+void ImplicitTreeView::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) return;
+    dragging = false;
+    setCursor(Qt::OpenHandCursor);
+    // a click without drag selects the node under the cursor
+    if ((event->position().toPoint() - pressPos).manhattanLength() < 4) {
+        uint64_t hit = hitTest(event->position());
+        if (hit != ImplicitFibTree::NO_INDEX) {
+            setSelected(hit);
+            emit nodeSelected(hit);
+        }
+    }
+}
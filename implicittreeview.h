@@ -0,0 +1,71 @@
+#ifndef IMPLICITTREEVIEW_H
+#define IMPLICITTREEVIEW_H
+
+#include <QWidget>
+#include <QPoint>
+#include <cstdint>
+#include "implicittree.h"
+
+// Viewer for an ImplicitFibTree. Scene coordinates of trees with trillions of nodes
+// do not fit a double, so the camera keeps its left edge as an integer leaf slot plus
+// a fraction and only the visible window of the tree is ever enumerated.
+class ImplicitTreeView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ImplicitTreeView(QWidget* parent = nullptr);
+
+    void setTree(int n);
+    const ImplicitFibTree& tree() const { return fibTree; }
+
+    // nodes whose preorder index is below count are shown
+    uint64_t revealedCount() const { return revealCount; }
+    void setRevealedCount(uint64_t count);
+
+    void fitAll();
+    void centerOn(uint64_t index);
+    void setSelected(uint64_t index);
+
+signals:
+    void nodeSelected(uint64_t index);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    ImplicitFibTree fibTree;
+    uint64_t revealCount = 0;
+    uint64_t selected = ImplicitFibTree::NO_INDEX;
+
+    // camera: slot at the left edge = originSlot + originFrac
+    int64_t originSlot = 0;
+    double originFrac = 0.0;  // kept in [0, 1)
+    double slotPx = 110.0;    // screen px per leaf slot
+    double rowPx = 100.0;     // screen px per depth level
+    double offsetY = 0.0;     // screen px scrolled down
+    double fitSlotPx = 1.0;
+    double fitRowPx = 1.0;
+
+    bool autoFit = true;      // refit on resize until the user moves the camera
+    bool dragging = false;
+    QPoint lastDrag;
+    QPoint pressPos;
+
+    double screenX(uint64_t slot, double offset) const;
+    double screenY(int depth) const { return depth * rowPx - offsetY; }
+    double nodeScale() const;
+    void panSlots(double delta);
+    void clampCamera();
+    uint64_t hitTest(const QPointF& pos) const;
+
+    // enumerate the nodes inside the viewport; visitor as in ImplicitFibTree::visitWindow
+    template <class Visit>
+    void visitVisible(Visit&& visit) const;
+};
+
+#endif // IMPLICITTREEVIEW_H
@@ -0,0 +1,116 @@
+#include "logplot.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+#include <cmath>
+
+// plot area insets: axis labels left and below, title above
+static const int MARGIN_LEFT = 56;
+static const int MARGIN_RIGHT = 12;
+static const int MARGIN_TOP = 26;
+static const int MARGIN_BOTTOM = 40;
+
+LogPlot::LogPlot(const QString& t, const QString& x, const QString& y, QWidget* parent)
+    : QWidget(parent), title(t), xLabel(x), yLabel(y) {
+    setMinimumSize(240, 180);
+}
+
+void LogPlot::setSeries(int index, const QString& name, const QColor& color) {
+    if (int(series.size()) <= index) series.resize(size_t(index) + 1);
+    series[index].name = name;
+    series[index].color = color;
+    update();
+}
+
+void LogPlot::addPoint(int s, double x, double y, double yLow, double yHigh) {
+    if (x <= 0 || y <= 0 || s >= int(series.size())) return;
+    series[s].points.push_back({x, y, yLow > 0 ? yLow : y, yHigh > 0 ? yHigh : y});
+    update();
+}
+
+void LogPlot::clearPoints() {
+    for (Series &s : series) s.points.clear();
+    update();
+}
+
+void LogPlot::paintEvent(QPaintEvent*) {
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.fillRect(rect(), QColor(15, 23, 36));
+    p.setPen(QColor(230, 238, 248));
+    p.drawText(QRect(0, 4, width(), MARGIN_TOP - 4), Qt::AlignHCenter | Qt::AlignVCenter, title);
+
+    const QRectF area(MARGIN_LEFT, MARGIN_TOP, width() - MARGIN_LEFT - MARGIN_RIGHT,
+                      height() - MARGIN_TOP - MARGIN_BOTTOM);
+    if (area.width() <= 0 || area.height() <= 0) return;
+
+    // whole decades around everything plotted
+    double x0 = 1e300, x1 = 0, y0 = 1e300, y1 = 0;
+    for (const Series &s : series) {
+        for (const Point &pt : s.points) {
+            x0 = std::min(x0, pt.x);
+            x1 = std::max(x1, pt.x);
+            y0 = std::min(y0, pt.low);
+            y1 = std::max(y1, pt.high);
+        }
+    }
+    if (x1 <= 0) {
+        x0 = y0 = 1;
+        x1 = y1 = 10;
+    }
+    const int dx0 = int(std::floor(std::log10(x0))), dx1 = std::max(dx0 + 1, int(std::ceil(std::log10(x1))));
+    const int dy0 = int(std::floor(std::log10(y0))), dy1 = std::max(dy0 + 1, int(std::ceil(std::log10(y1))));
+    auto mapX = [&](double x) { return area.left() + (std::log10(x) - dx0) / (dx1 - dx0) * area.width(); };
+    auto mapY = [&](double y) { return area.bottom() - (std::log10(y) - dy0) / (dy1 - dy0) * area.height(); };
+
+    // decade grid and labels
+    p.setPen(QColor(60, 72, 92));
+    for (int d = dx0; d <= dx1; ++d) p.drawLine(QPointF(mapX(std::pow(10.0, d)), area.top()), QPointF(mapX(std::pow(10.0, d)), area.bottom()));
+    for (int d = dy0; d <= dy1; ++d) p.drawLine(QPointF(area.left(), mapY(std::pow(10.0, d))), QPointF(area.right(), mapY(std::pow(10.0, d))));
+    p.setPen(QColor(180, 190, 205));
+    // at most about eight labels per axis
+    const int xStep = std::max(1, (dx1 - dx0 + 7) / 8), yStep = std::max(1, (dy1 - dy0 + 7) / 8);
+    for (int d = dx0; d <= dx1; d += xStep) {
+        p.drawText(QRectF(mapX(std::pow(10.0, d)) - 30, area.bottom() + 2, 60, 16), Qt::AlignHCenter, QString("1e%1").arg(d));
+    }
+    for (int d = dy0; d <= dy1; d += yStep) {
+        p.drawText(QRectF(0, mapY(std::pow(10.0, d)) - 8, MARGIN_LEFT - 4, 16), Qt::AlignRight | Qt::AlignVCenter, QString("1e%1").arg(d));
+    }
+    p.drawText(QRectF(area.left(), height() - 18, area.width(), 16), Qt::AlignHCenter, xLabel);
+    p.save();
+    p.translate(12, area.center().y());
+    p.rotate(-90);
+    p.drawText(QRectF(-area.height() / 2, -10, area.height(), 16), Qt::AlignHCenter, yLabel);
+    p.restore();
+
+    // series: line through the points, whiskers for their ranges, legend top left
+    p.setClipRect(area.adjusted(-4, -4, 4, 4));
+    for (const Series &s : series) {
+        if (s.points.empty()) continue;
+        QPainterPath path;
+        for (size_t i = 0; i < s.points.size(); ++i) {
+            const QPointF at(mapX(s.points[i].x), mapY(s.points[i].y));
+            if (i == 0) path.moveTo(at);
+            else path.lineTo(at);
+        }
+        p.setPen(QPen(s.color, 2));
+        p.setBrush(Qt::NoBrush);
+        p.drawPath(path);
+        p.setPen(QPen(s.color, 1));
+        p.setBrush(s.color);
+        for (const Point &pt : s.points) {
+            const double x = mapX(pt.x);
+            if (pt.high > pt.low) p.drawLine(QPointF(x, mapY(pt.low)), QPointF(x, mapY(pt.high)));
+            p.drawEllipse(QPointF(x, mapY(pt.y)), 2.5, 2.5);
+        }
+    }
+    p.setClipping(false);
+    int legendY = int(area.top()) + 4;
+    for (const Series &s : series) {
+        if (s.name.isEmpty()) continue;
+        p.fillRect(QRectF(area.left() + 6, legendY + 4, 10, 4), s.color);
+        p.setPen(QColor(230, 238, 248));
+        p.drawText(QPointF(area.left() + 20, legendY + 10), s.name);
+        legendY += 14;
+    }
+}
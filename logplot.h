@@ -0,0 +1,39 @@
+#ifndef LOGPLOT_H
+#define LOGPLOT_H
+
+#include <QColor>
+#include <QString>
+#include <QWidget>
+#include <vector>
+
+// Line chart on log-log axes, one series per index, filled in point by point.
+// Points may carry a low/high range, drawn as a whisker; non-positive values are skipped.
+class LogPlot : public QWidget {
+    Q_OBJECT
+
+public:
+    LogPlot(const QString& title, const QString& xLabel, const QString& yLabel, QWidget* parent = nullptr);
+
+    void setSeries(int index, const QString& name, const QColor& color);
+    void addPoint(int series, double x, double y, double yLow = 0, double yHigh = 0);
+    void clearPoints();
+
+    QSize sizeHint() const override { return QSize(420, 300); }
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    struct Point {
+        double x, y, low, high;
+    };
+    struct Series {
+        QString name;
+        QColor color;
+        std::vector<Point> points;
+    };
+    QString title, xLabel, yLabel;
+    std::vector<Series> series;
+};
+
+#endif // LOGPLOT_H
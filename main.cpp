@@ -1,8 +1,18 @@
 #include <QApplication>
+#include <cstring>
+#include "headless.h"
 #include "mainwindow.h"
 
 int main(int argc, char *argv[]) {
+    // --headless runs the pipeline benchmark instead of the window (see headless.h)
+    bool headless = false;
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--headless") == 0) headless = true;
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
+    if (headless) return runHeadless(a.arguments());
     MainWindow w;
     w.show();
     return a.exec();
@@ -1,70 +1,101 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "nodeitem.h"
+#include "virtualscene.h"
+#include "treepainteritem.h"
+#include "treescene.h"
+#include "implicittreeview.h"
+#include "fibvalues.h"
+#include "treebuilder.h"
+#include "revealanimator.h"
+#include "profiler.h"
+#include "treefile.h"
+#include "treeexport.h"
+#include "memodag.h"
+#include "nodeindex.h"
+#include "resourcegovernor.h"
+#include "revealtimeline.h"
+#include "calltracer.h"
+#include "algobenchpanel.h"
+#include "minimap.h"
+#include "recurrence.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QMessageBox>
-#include <QGraphicsLineItem>
 #include <QFont>
 #include <QWheelEvent>
+#include <QMouseEvent>
 #include <QTextEdit>
-#include <QLinearGradient>
+#include <QScrollBar>
+#include <QMenu>
+#include <QMenuBar>
+#include <QAction>
+#include <QDockWidget>
+#include <QFileDialog>
+#include <QSaveFile>
+#include <QInputDialog>
+#include <QSignalBlocker>
 #include <QStringList>
+#include <QRegularExpression>
+#include <algorithm>
 #include <cmath>
 
-// Tunable geometry
-static const double H_GAP = 110.0; // pixel per logical x unit (horizontal spacing)
-static const double V_GAP = 100.0; // vertical gap in pixels
-
-// ---------------- NodeItem ----------------
-NodeItem::NodeItem(FibNode* node, QGraphicsItem* parent)
-    : QGraphicsEllipseItem(parent), nodePtr(node) {
-    // rounded rect centered at (0,0)
-    setRect(-50, -28, 100, 56);
-    // modern off-white pen for subtle border
-    setPen(QPen(QColor(240, 244, 249), 1));
-    setFlag(ItemIsSelectable);
-    setFlag(ItemSendsScenePositionChanges);
-
-    // label (main: F(n))
-    label = new QGraphicsTextItem(this);
-    label->setDefaultTextColor(QColor(250,250,252));
-    label->setFont(QFont("Segoe UI", 10, QFont::Bold));
-    label->setPos(-15, -25);
-
-    // subLabel (value)
-    subLabel = new QGraphicsTextItem(this);
-    subLabel->setDefaultTextColor(QColor(200, 220, 235));
-    subLabel->setFont(QFont("Segoe UI", 8));
-    subLabel->setPos(-46, -4);
-
-    applyStyle();
-}
-
-void NodeItem::applyStyle() {
-    // modern purple -> teal gradient for nodes
-    QLinearGradient grad(rect().topLeft(), rect().bottomRight());
-    grad.setColorAt(0.0, QColor(51, 65, 151));   // deep indigo (#334197)
-    grad.setColorAt(1.0, QColor(20, 184, 166));  // teal-accent (#14B8A6)
-    setBrush(QBrush(grad));
-}
-
-void NodeItem::setHighlighted(bool on) {
-    if (on) {
-        // warm accent gradient for selection (coral -> amber)
-        QLinearGradient grad(rect().topLeft(), rect().bottomRight());
-        grad.setColorAt(0.0, QColor(255, 94, 98));
-        grad.setColorAt(1.0, QColor(255, 159, 67));
-        setBrush(grad);
-    } else {
-        if (nodePtr->isCached) {
-            // muted slate gradient for cached nodes
-            QLinearGradient grad(rect().topLeft(), rect().bottomRight());
-            grad.setColorAt(0.0, QColor(95, 105, 125));
-            grad.setColorAt(1.0, QColor(65, 75, 95));
-            setBrush(grad);
-            setPen(QPen(QColor(240, 244, 249), 1));
-        } else {
-            applyStyle();
-        }
+// spin box limits; which renderer can show a tree is up to the resource governor
+static const int MAX_MEMO_N = 100000;
+static const int MAX_MEMO_DAG_N = 2000;
+static const int MAX_VALUE_ONLY_N = 10000000;
+// largest n the linear big-integer loop is timed for next to fast doubling
+static const int MAX_LINEAR_COMPARE_N = 100000;
+// GUI time spent creating scene items before yielding to the event loop
+static const int POPULATE_SLICE_MS = 8;
+// Skip reveals the rest of any tree within about this long, spending at most
+// SKIP_FRAME_BUDGET_MS per frame and animating only the first few nodes of a frame
+static const int SKIP_DURATION_MS = 1500;
+static const int SKIP_FRAME_BUDGET_MS = 8;
+static const int MAX_POPS_PER_FRAME = 32;
+// timeline steps per seek while skipping, so the frame budget is checked in between
+static const size_t SKIP_SEEK_STEPS = 256;
+// traced runs: calls recorded at most, and recursion depth on the GUI thread's stack
+static const uint64_t MAX_TRACE_CALLS = 8000000;
+static const int MAX_TRACE_DEPTH = 5000;
+// call paths listed per node in the memo DAG view
+static const size_t DAG_PATHS_SHOWN = 4;
+// longer side of exported PNGs
+static const int PNG_EXPORT_MAX_SIDE = 8192;
+static const char *const TREE_FILE_FILTER = "Call trees (*.fibtree)";
+// refresh interval of the profiler summary in the info panel
+static const int PROFILER_REFRESH_MS = 500;
+
+static_assert(int(StrategyImplicit) == int(RenderImplicit), "Strategy and RenderMode values must match");
+
+// "F(7)", or "T(7)" for Tribonacci and so on
+static QString callName(RecurrenceRule rule, int k) {
+    return QString("%1(%2)").arg(QChar(recurrenceSymbol(rule))).arg(k);
+}
+
+// Search box query: "F(7)" or "7", "7#3" for the third call, or a path from the root
+// such as "6/5/3" or "F(6) -> F(5)" (any rule's symbol). False when malformed.
+static bool parseQuery(QString text, std::vector<int>* path, uint64_t* nth) {
+    text.remove(QRegularExpression("[A-Za-z()\\s]"));
+    *nth = 0;
+    const int hash = text.indexOf('#');
+    if (hash >= 0) {
+        bool ok = false;
+        *nth = text.mid(hash + 1).toULongLong(&ok);
+        if (!ok || *nth == 0) return false;
+        text.truncate(hash);
+    }
+    text.replace("->", "/");
+    path->clear();
+    for (const QString &term : text.split('/')) {
+        bool ok = false;
+        const int k = term.toInt(&ok);
+        if (!ok || k < 0) return false;
+        path->push_back(k);
     }
+    return !path->empty() && (*nth == 0 || path->size() == 1);
 }
 
 // ---------------- MainWindow ----------------
@@ -80,22 +111,133 @@ MainWindow::MainWindow(QWidget *parent)
     // intercept wheel events for zoom (install on viewport)
     ui->graphicsView->viewport()->installEventFilter(this);
 
-    // Hook up signals
-    connect(ui->btnDraw, &QPushButton::clicked, this, &MainWindow::on_btnDraw_clicked);
+    virtualScene = new VirtualTreeScene(scene, ui->graphicsView, this);
+    treeScene = new TreeScene(scene, virtualScene);
+
+    // the implicit renderer replaces the graphics view while it is active
+    implicitView = new ImplicitTreeView(this);
+    ui->mainLayout->insertWidget(1, implicitView);
+    implicitView->hide();
+    connect(implicitView, &ImplicitTreeView::nodeSelected, this, &MainWindow::updateInfoForImplicitNode);
+
+    // overview of the whole layout; navigating it only scrolls the view, which re-queries its viewport
+    miniMap = new MiniMap(this);
+    QDockWidget *overviewDock = new QDockWidget("Overview", this);
+    overviewDock->setObjectName("overviewDock");
+    overviewDock->setWidget(miniMap);
+    addDockWidget(Qt::RightDockWidgetArea, overviewDock);
+    connect(miniMap, &MiniMap::centerRequested, this, [this](const QPointF &scenePos) {
+        ui->graphicsView->centerOn(scenePos);
+        virtualScene->scheduleRefresh();
+    });
+    for (QScrollBar *bar : {ui->graphicsView->horizontalScrollBar(), ui->graphicsView->verticalScrollBar()}) {
+        connect(bar, &QScrollBar::valueChanged, this, &MainWindow::updateMiniMapView);
+        connect(bar, &QScrollBar::rangeChanged, this, &MainWindow::updateMiniMapView);
+    }
+
+    // build and layout run on a worker; progress and cancel live in the status bar
+    builder = new TreeBuilder(this);
+    builder->setStoreLimit(size_t(governor.storeBudget()));
+    buildProgress = new QProgressBar(this);
+    buildProgress->setRange(0, 100);
+    buildProgress->setMaximumWidth(180);
+    btnCancelBuild = new QPushButton("Cancel", this);
+    ui->statusbar->addPermanentWidget(buildProgress);
+    ui->statusbar->addPermanentWidget(btnCancelBuild);
+    setBuildUiVisible(false);
+    connect(builder, &TreeBuilder::progress, buildProgress, &QProgressBar::setValue);
+    connect(builder, &TreeBuilder::finished, this, &MainWindow::onTreeBuilt);
+    connect(builder, &TreeBuilder::valueFinished, this, &MainWindow::onValueComputed);
+    connect(btnCancelBuild, &QPushButton::clicked, this, &MainWindow::cancelBuild);
+    connect(ui->spinBoxN, &QSpinBox::valueChanged, this, &MainWindow::restartBuildIfRunning);
+    populateTimer.setInterval(0);
+    connect(&populateTimer, &QTimer::timeout, this, &MainWindow::populateSceneItems);
+
+    // Hook up signals (btnDraw, btnStep and btnSkip are connected by name in setupUi)
     connect(&animTimer, &QTimer::timeout, this, &MainWindow::on_stepAnimation);
-    connect(&nodesTimer, &QTimer::timeout, this, &MainWindow::on_showNextNode);
-    connect(ui->btnSkip, &QPushButton::clicked, this, &MainWindow::on_btnSkip_clicked);
+    animator = new RevealAnimator(this);
+    connect(animator, &RevealAnimator::frame, this, &MainWindow::onRevealFrame);
+    connect(ui->radioNaive, &QRadioButton::toggled, this, &MainWindow::updateRangeForMode);
+    connect(ui->radioMemo, &QRadioButton::toggled, this, &MainWindow::updateRangeForMode);
+    connect(ui->radioMemoDag, &QRadioButton::toggled, this, &MainWindow::updateRangeForMode);
+    connect(ui->radioValueOnly, &QRadioButton::toggled, this, &MainWindow::updateRangeForMode);
+    connect(ui->searchBox, &QLineEdit::returnPressed, this, &MainWindow::findNode);
+    connect(ui->timelineSlider, &QSlider::valueChanged, this, &MainWindow::seekFromSlider);
+    connect(ui->comboSchedule, &QComboBox::currentIndexChanged, this, &MainWindow::changeSchedule);
+
+    // trees are saved with their layout and opened without rebuilding
+    QMenu *fileMenu = ui->menubar->addMenu("File");
+    fileMenu->addAction("Open tree...", this, &MainWindow::openTree);
+    fileMenu->addAction("Save tree...", this, &MainWindow::saveTree);
+    fileMenu->addSeparator();
+    fileMenu->addAction("Export SVG...", this, &MainWindow::exportSvg);
+    fileMenu->addAction("Export PNG...", this, &MainWindow::exportPng);
+
+    // profiler: off until Record is checked; its summary is appended to the info panel
+    QMenu *profilerMenu = ui->menubar->addMenu("Profiler");
+    QAction *actRecord = profilerMenu->addAction("Record");
+    actRecord->setCheckable(true);
+    connect(actRecord, &QAction::toggled, this, &MainWindow::setProfilerEnabled);
+    actProfilerSummary = profilerMenu->addAction("Show summary in info panel");
+    actProfilerSummary->setCheckable(true);
+    actProfilerSummary->setChecked(true);
+    connect(actProfilerSummary, &QAction::toggled, this, &MainWindow::refreshInfoText);
+    profilerMenu->addSeparator();
+    profilerMenu->addAction("Reset", this, [this]() {
+        Profiler::clear();
+        refreshInfoText();
+    });
+    profilerMenu->addAction("Export Chrome trace...", this, &MainWindow::exportTrace);
+    profilerTimer.setInterval(PROFILER_REFRESH_MS);
+    connect(&profilerTimer, &QTimer::timeout, this, &MainWindow::refreshInfoText);
+
+    // real runs of the algorithms, recorded call by call and drawn colored by measured time
+    QMenu *traceMenu = ui->menubar->addMenu("Trace");
+    for (int a = 0; a < TraceAlgorithmCount; ++a) {
+        const TraceAlgorithm algorithm = TraceAlgorithm(a);
+        traceMenu->addAction(QString("Trace %1").arg(CallTracer::algorithmName(algorithm)), this,
+                             [this, algorithm]() { traceRun(algorithm); });
+    }
+
+    // trees of the other recurrences share the naive and memoized views; the F(k) specific
+    // features (traces, the memo DAG and the implicit view) are off while one is selected
+    for (int r = 0; r < RuleCount; ++r) ui->comboRecurrence->addItem(recurrenceName(RecurrenceRule(r)));
+    connect(ui->comboRecurrence, &QComboBox::currentIndexChanged, this, [this, traceMenu](int rule) {
+        traceMenu->setEnabled(rule == RuleFibonacci);
+        updateRangeForMode();
+        restartBuildIfRunning();
+    });
+
+    // naive, memoized, DP loop, matrix power and fast doubling timed over an n range
+    QMenu *benchmarkMenu = ui->menubar->addMenu("Benchmark");
+    benchmarkMenu->addAction("Compare algorithms...", this, [this]() {
+        if (!algoBenchPanel) algoBenchPanel = new AlgoBenchPanel(this);
+        algoBenchPanel->show();
+        algoBenchPanel->raise();
+    });
+
+    // what Draw may allocate follows a cost model calibrated on this machine
+    QMenu *limitsMenu = ui->menubar->addMenu("Limits");
+    limitsMenu->addAction("Memory budget...", this, &MainWindow::editMemoryBudget);
+    limitsMenu->addAction("Recalibrate", this, [this]() {
+        governor.calibrate();
+        ui->statusbar->showMessage(governor.calibrationText());
+    });
+    governor.calibrate();
+
+    QMenu *viewMenu = ui->menubar->addMenu("View");
+    viewMenu->addAction(overviewDock->toggleViewAction());
 
     // sensible defaults
-    ui->spinBoxN->setRange(0, 40);
-    ui->spinBoxN->setValue(6);
     ui->radioNaive->setChecked(true);
+    updateRangeForMode();
+    ui->spinBoxN->setValue(6);
 
     // info area read-only + modern styling
     ui->infoText->setReadOnly(true);
     ui->infoText->setFont(QFont("Segoe UI", 16));
     ui->infoText->setStyleSheet("QTextEdit{ background: #0f1724; color: #E6EEF8; border-radius:8px; padding:8px; }");
-    ui->infoText->setPlainText("Press Draw to build the tree. Use Step to reveal one node (root appears first), Skip to reveal the rest quickly.");
+    setInfoText("Press Draw to build the tree. Use Step to reveal one node (root appears first), Skip to reveal the rest quickly, Back or the slider to rewind.");
 
     // modernize buttons/colors via stylesheet
     QString btnStyle = R"(
@@ -113,202 +255,131 @@ MainWindow::MainWindow(QWidget *parent)
     ui->btnDraw->setStyleSheet(btnStyle);
     ui->btnStep->setStyleSheet(btnStyle);
     ui->btnSkip->setStyleSheet(btnStyle);
+    ui->btnBack->setStyleSheet(btnStyle);
 
-    // initially disable step/skip
-    ui->btnStep->setEnabled(false);
-    ui->btnSkip->setEnabled(false);
+    // initially disable step/skip/back
+    updateStepSkipButtons();
+    updateTimelineUi();
 }
 
 MainWindow::~MainWindow() {
     clearSceneAndMemory();
+    delete treeScene;
     delete ui;
 }
 
-// ---------------- build trees ----------------
-FibNode* MainWindow::buildNaiveFib(int n) {
-    FibNode* root = new FibNode(n);
-    allNodes.push_back(root);
-    if (n <= 1) {
-        root->value = int(n);
-        return root;
-    }
-    root->children.push_back(buildNaiveFib(n-1));
-    root->children.push_back(buildNaiveFib(n-2));
-    root->value = root->children[0]->value + root->children[1]->value;
-    return root;
-}
-
-FibNode* MainWindow::buildMemoFib(int n, std::unordered_map<int, FibNode*>& memo) {
-    auto it = memo.find(n);
-    if (it != memo.end()) {
-        FibNode* leaf = new FibNode(n);
-        leaf->isCached = true;
-        leaf->value = it->second->value;
-        allNodes.push_back(leaf);
-        return leaf;
-    }
-
-    FibNode* root = new FibNode(n);
-    allNodes.push_back(root);
-    if (n <= 1) {
-        root->value = static_cast<unsigned long long>(n);
-        memo[n] = root;
-        return root;
-    }
-    FibNode* left = buildMemoFib(n-1, memo);
-    FibNode* right = buildMemoFib(n-2, memo);
-    root->children.push_back(left);
-    root->children.push_back(right);
-    root->value = left->value + right->value;
-    memo[n] = root;
-    return root;
-}
-
-// ---------------- layout ----------------
-double MainWindow::computeWidths(FibNode* node, std::unordered_map<FibNode*, double>& widths) {
-    if (!node) return 0.0;
-    if (node->children.empty()) {
-        widths[node] = 1.0;
-        return 1.0;
-    }
-    double sum = 0.0;
-    for (auto c : node->children) sum += computeWidths(c, widths);
-    widths[node] = sum;
-    return sum;
-}
-
-void MainWindow::assignPositions(FibNode* node, double &cursorX, int depth, double horizUnit, double vertGap) {
-    if (!node) return;
-    node->depth = depth;
-    if (node->children.empty()) {
-        node->x = cursorX;         // logical coordinate
-        node->y = depth * vertGap; // pixel y
-        cursorX += 1.0;            // advance leaf slot
+// ---------------- draw & helpers ----------------
+void MainWindow::drawTree() {
+    treeScene->setTree(&tree, renderMode, trace.heat.empty() ? nullptr : &trace.heat, dagMode ? &memoDag : nullptr);
+    if (TreePainterItem *painterItem = treeScene->painterItem()) {
+        connect(painterItem, &TreePainterItem::painted, this, [this](double ms, int nodesDrawn) {
+            ui->statusbar->showMessage(QString("Painted %1 nodes in %2 ms").arg(nodesDrawn).arg(ms, 0, 'f', 2));
+        });
+    }
+    if (renderMode == RenderItems) {
+        // items are created a slice at a time; finishDraw() runs once they all exist
+        populateTimer.start();
         return;
     }
-    for (auto c : node->children) assignPositions(c, cursorX, depth+1, horizUnit, vertGap);
-    double left = node->children.front()->x;
-    double right = node->children.back()->x;
-    node->x = (left + right) / 2.0;
-    node->y = depth * vertGap;
+    finishDraw();
 }
 
-// ---------------- draw & helpers ----------------
-void MainWindow::drawTree(FibNode* root) {
-    scene->clear();
-    nodeItems.clear();
-    edges.clear();
-    edgePairs.clear();
-    parentMap.clear();
-
-    for (FibNode* c : allNodes) {
-        NodeItem* it = new NodeItem(c);
-        it->label->setPlainText(QString("F(%1)").arg(c->n));
-        it->subLabel->setPlainText(QString("= %1").arg(c->value));
-        double px = c->x * H_GAP;
-        double py = c->y;
-        it->setPos(px, py);
-        it->setVisible(false);   // start hidden, will reveal one by one
-        it->setScale(0.2);       // small initial scale for a pop-in effect
-        scene->addItem(it);
-        nodeItems[c] = it;
-    }
-
-    // draw edges but hide them initially
-    for (FibNode* p : allNodes) {
-        for (FibNode* ch : p->children) {
-            NodeItem* pit = nodeItems[p];
-            NodeItem* cit = nodeItems[ch];
-            if (!pit || !cit) continue;
-            QGraphicsLineItem* line = scene->addLine(QLineF(pit->pos(), cit->pos()));
-            line->setZValue(-1);
-            line->setVisible(false);
-            if (ch->isCached) {
-                QPen pen = line->pen();
-                pen.setStyle(Qt::DashLine);
-                line->setPen(pen);
-            }
-            edges.push_back(line);
-            edgePairs.push_back({p, ch});
-            // store a parent mapping for the first parent seen
-            if (parentMap.find(ch) == parentMap.end()) parentMap[ch] = p;
-        }
-    }
+void MainWindow::finishDraw() {
+    PROFILE_SCOPE("finish draw");
+    setBuildUiVisible(false);
 
-    // collect visit order (preorder) for reveal; could be any order you prefer
-    visitOrder.clear();
-    collectVisitOrder(root);
+    // the reveal follows a timeline of the chosen schedule; if animate is checked, only its
+    // first step is taken and the rest waits for Step clicks
+    stopSkip();
+    treeScene->startReveal(RevealSchedule(ui->comboSchedule->currentIndex()));
+    seekTimeline(ui->checkBoxAnimate->isChecked() ? 1 : treeScene->timeline().length(), 0);
+    updateStepSkipButtons();
+    if (!tree.empty()) showActiveNode();
+    miniMap->setTree(&tree, &treeScene->revealed());
 
-    // Prepare reveal state: if animate is checked, show root only and wait for Step clicks
-    nodeRevealIndex = 0;
-    skipMode = false;
-    nodesTimer.stop();
-    nodesTimer.setInterval(normalRevealInterval);
-
-    if (ui->checkBoxAnimate->isChecked() && !visitOrder.empty()) {
-        // reveal only root immediately (visitOrder[0]) and leave others hidden
-        NodeItem* rootItem = visitOrder[0];
-        rootItem->setVisible(true);
-        rootItem->setScale(1.0);
-        // make sure cached nodes styled
-        rootItem->setHighlighted(false);
-
-        // show edges only when both endpoints become visible (none yet)
-        nodeRevealIndex = 1; // next reveal will be visitOrder[1]
-
-        ui->btnStep->setEnabled(true);
-        ui->btnSkip->setEnabled(true);
-    } else {
-        // reveal all immediately with a small scale effect
-        for (auto &kv : nodeItems) {
-            kv.second->setVisible(true);
-            kv.second->setScale(1.0);
-        }
-        // show edges once both endpoints visible
-        for (size_t i = 0; i < edges.size(); ++i) {
-            FibNode* p = edgePairs[i].first;
-            FibNode* c = edgePairs[i].second;
-            if (nodeItems[p]->isVisible() && nodeItems[c]->isVisible()) edges[i]->setVisible(true);
+    // fit view to content (if any)
+    const QRectF bounds = treeScene->bounds();
+    if (!bounds.isEmpty()) ui->graphicsView->fitInView(bounds, Qt::KeepAspectRatio);
+    if (renderMode == RenderVirtualized) virtualScene->refresh();
+    updateMiniMapView();
+}
+
+void MainWindow::populateSceneItems() {
+    // stops after a time slice and continues on the next timer tick
+    const bool done = treeScene->populate(POPULATE_SLICE_MS);
+    buildProgress->setValue(treeScene->populatePercent());
+    if (!done) return;
+
+    populateTimer.stop();
+    finishDraw();
+}
+
+void MainWindow::seekTimeline(size_t step, int popIns) {
+    const std::vector<NodeId> &changes = treeScene->seek(step);
+    // animate scale from small -> 1.0 for a pop effect (only if the node is materialized)
+    for (NodeId v : changes) {
+        if (popIns <= 0) break;
+        if (!treeScene->timeline().isVisible(v)) continue;
+        if (NodeItem* it = treeScene->itemFor(v)) {
+            animator->popIn(it);
+            --popIns;
         }
-        ui->btnStep->setEnabled(false);
-        ui->btnSkip->setEnabled(false);
     }
+    miniMap->nodesChanged(changes);
+    updateTimelineUi();
+}
 
-    // update info to mention root if visible
-    if (!visitOrder.empty()) {
-        FibNode* rootN = visitOrder[0]->nodePtr;
-        updateInfoForNode(rootN, nullptr);
-    }
+void MainWindow::updateTimelineUi() {
+    const RevealTimeline &timeline = treeScene->timeline();
+    const QSignalBlocker blocker(ui->timelineSlider);
+    ui->timelineSlider->setRange(0, int(timeline.length()));
+    ui->timelineSlider->setPageStep(std::max(1, int(timeline.length() / 20)));
+    ui->timelineSlider->setValue(int(timeline.position()));
+    ui->timelineLabel->setText(QString("Step %1 / %2").arg(qulonglong(timeline.position())).arg(qulonglong(timeline.length())));
+}
+
+void MainWindow::showActiveNode() {
+    // before the first step and after the root returned, the root stands for the tree
+    NodeId node = treeScene->timeline().activeNode(tree);
+    if (node == NO_NODE) node = 0;
+    updateInfoForNode(node, tree.parent[node]);
 }
 
-void MainWindow::collectVisitOrder(FibNode* node) {
-    if (!node) return;
-    auto it = nodeItems.find(node);
-    if (it != nodeItems.end()) visitOrder.push_back(it->second);
-    for (auto c : node->children) collectVisitOrder(c);
+void MainWindow::updateMiniMapView() {
+    const QRect visible = ui->graphicsView->viewport()->rect();
+    miniMap->setViewRect(ui->graphicsView->mapToScene(visible).boundingRect());
 }
 
 void MainWindow::clearSceneAndMemory() {
-    nodesTimer.stop();
+    builder->cancel();
+    populateTimer.stop();
+    setBuildUiVisible(false);
+    stopSkip();
+    animator->clear(); // its items are deleted below
     animTimer.stop();
-    scene->clear();
-    for (FibNode* p : allNodes) delete p;
-    allNodes.clear();
-    nodeItems.clear();
-    edges.clear();
-    edgePairs.clear();
-    parentMap.clear();
-    visitOrder.clear();
-    nodeRevealIndex = 0;
+    miniMap->clear(); // waits for its count, which reads the tree and its reveal state
+    treeScene->clear();
+    tree.clear();
+    memoDag.clear();
+    trace = CallTrace();
+    dagMode = false;
+    nodeIndex.clear();
+    selectedNode = NO_NODE;
+    lastQuery.clear();
+    pathNode = NO_NODE;
+    updateTimelineUi();
     ui->btnStep->setEnabled(false);
     ui->btnSkip->setEnabled(false);
+    ui->btnBack->setEnabled(false);
 }
 
 // ---------------- animation step for visit-highlighting (kept for compatibility) ----------------
 void MainWindow::on_stepAnimation() {
-    if (animIndex < visitOrder.size()) {
-        visitOrder[animIndex]->setHighlighted(true);
-        ui->graphicsView->centerOn(visitOrder[animIndex]);
+    if (animIndex < treeScene->timeline().length()) {
+        if (NodeItem* it = treeScene->itemFor(treeScene->timeline().event(animIndex).node)) {
+            it->setHighlighted(true);
+            ui->graphicsView->centerOn(it);
+        }
         ++animIndex;
     } else {
         animTimer.stop();
@@ -317,98 +388,383 @@ void MainWindow::on_stepAnimation() {
 
 // ---------------- show nodes one by one (cool pop-in) ----------------
 void MainWindow::on_showNextNode() {
-    if (nodeRevealIndex >= visitOrder.size()) {
-        nodesTimer.stop();
-        ui->btnStep->setEnabled(false);
-        ui->btnSkip->setEnabled(false);
-        skipMode = false;
+    PROFILE_SCOPE("show next node");
+    if (renderMode == RenderImplicit) {
+        showNextImplicitNode();
+        return;
+    }
+    if (!hasUnrevealed()) {
+        stopSkip();
+        updateStepSkipButtons();
         return;
     }
 
-    NodeItem* it = visitOrder[nodeRevealIndex++];
-    // reveal node
-    it->setVisible(true);
+    // one event of the schedule; in call/return order a return only moves the active frame
+    seekTimeline(treeScene->timeline().position() + 1, 1);
+    showActiveNode();
 
-    // animate scale from small -> 1.0 for a pop effect
-    QVariantAnimation *anim = new QVariantAnimation(this);
-    anim->setDuration(220);
-    anim->setStartValue(0.25);
-    anim->setEndValue(1.0);
-    // when anim value changes, update scale
-    connect(anim, &QVariantAnimation::valueChanged, this, [it](const QVariant &v) {
-        it->setScale(v.toDouble());
-    });
-    // delete animator when done
-    connect(anim, &QVariantAnimation::finished, anim, &QObject::deleteLater);
-    anim->start();
-
-    // show edges that connect visible parent-child pairs
-    for (size_t i = 0; i < edges.size(); ++i) {
-        FibNode* p = edgePairs[i].first;
-        FibNode* c = edgePairs[i].second;
-        if (nodeItems[p]->isVisible() && nodeItems[c]->isVisible()) {
-            edges[i]->setVisible(true);
-        }
+    // if we've reached the end, disable step/skip
+    updateStepSkipButtons();
+}
+
+void MainWindow::showNextImplicitNode() {
+    if (!hasUnrevealed()) {
+        stopSkip();
+        updateStepSkipButtons();
+        return;
     }
+    // preorder index == reveal order, so the reveal state is a single counter
+    uint64_t index = implicitView->revealedCount();
+    implicitView->setRevealedCount(index + 1);
+    PROFILE_COUNT("nodes revealed", 1);
+    updateInfoForImplicitNode(index);
+    updateStepSkipButtons();
+}
 
+// ---------------- Skip: frame-driven reveal ----------------
+void MainWindow::onRevealFrame() {
+    if (!skipMode) return;
+    PROFILE_SCOPE("reveal frame");
+    const RevealTimeline &timeline = treeScene->timeline();
+    // steps due by now on a linear schedule that ends SKIP_DURATION_MS after the press
+    const uint64_t total = renderMode == RenderImplicit ? implicitView->tree().nodeCount() : timeline.length();
+    const double t = std::min(1.0, skipClock.elapsed() / double(SKIP_DURATION_MS));
+    const uint64_t due = t >= 1.0 ? total : skipFrom + uint64_t((total - skipFrom) * t);
 
-    // update info text about this revealed node
-    FibNode* thisNode = it->nodePtr;
-    FibNode* parentNode = nullptr;
-    auto pit = parentMap.find(thisNode);
-    if (pit != parentMap.end()) parentNode = pit->second;
-    updateInfoForNode(thisNode, parentNode);
+    if (renderMode == RenderImplicit) {
+        // the implicit view only keeps a counter
+        const uint64_t before = implicitView->revealedCount();
+        implicitView->setRevealedCount(std::max(due, before));
+        PROFILE_COUNT("nodes revealed", int64_t(implicitView->revealedCount() - before));
+        updateInfoForImplicitNode(implicitView->revealedCount() - 1);
+    } else if (t >= 1.0) {
+        // out of time: whatever the frame budget left behind appears at once
+        seekTimeline(timeline.length(), 0);
+        showActiveNode();
+    } else if (timeline.position() < due) {
+        QElapsedTimer budget;
+        budget.start();
+        int pops = MAX_POPS_PER_FRAME;
+        while (timeline.position() < due && budget.elapsed() < SKIP_FRAME_BUDGET_MS) {
+            seekTimeline(std::min<uint64_t>(due, timeline.position() + SKIP_SEEK_STEPS), pops);
+            pops = 0;
+        }
+        showActiveNode();
+    }
 
-    // if we've revealed all, disable step/skip
-    updateStepSkipButtons();
+    if (!hasUnrevealed()) {
+        stopSkip();
+        updateStepSkipButtons();
+    }
+}
+
+void MainWindow::stopSkip() {
+    skipMode = false;
+    animator->setFrameWork(false);
 }
 
 // ---------------- helper to update info text ----------------
-QString MainWindow::pathToRoot(FibNode* node) {
+QString MainWindow::pathToRoot(NodeId node) {
+    // Step and Skip ask for the same node again on every info refresh
+    if (node == pathNode) return pathText;
+    // memo trees are as deep as n, so only the ends of long paths are listed
+    const size_t keep = 8;
+    std::vector<NodeId> ids; // node first, root last
+    for (NodeId cur = node; cur != NO_NODE; cur = tree.parent[cur]) ids.push_back(cur);
     QStringList parts;
-    FibNode* cur = node;
-    while (cur) {
-        parts.prepend(QString("F(%1)").arg(cur->n));
-        auto it = parentMap.find(cur);
-        if (it == parentMap.end()) break;
-        cur = it->second;
+    for (size_t i = ids.size(); i-- > 0;) {
+        const size_t fromRoot = ids.size() - 1 - i;
+        if (fromRoot < keep || i < keep) parts << callName(tree.rule, tree.n[ids[i]]);
+        else if (fromRoot == keep) parts << QString("... (%1 more)").arg(ids.size() - 2 * keep);
+    }
+    pathNode = node;
+    pathText = parts.join(" -> ");
+    return pathText;
+}
+
+QString MainWindow::callPathsText(NodeId node) {
+    const uint64_t total = memoDag.pathCounts[node];
+    QString s = QString("Call paths from root: %1\n")
+                    .arg(total == UINT64_MAX ? QString("over 1.8e19") : QString::number(total));
+    // long paths keep their ends, as in pathToRoot()
+    const int keep = 4;
+    for (const auto &path : memoDag.pathsToRoot(node, DAG_PATHS_SHOWN)) {
+        QStringList parts;
+        for (NodeId id : path) parts << QString("F(%1)").arg(tree.n[id]);
+        if (parts.size() > 2 * keep) {
+            const int hidden = int(parts.size()) - 2 * keep;
+            parts = parts.mid(0, keep) + QStringList{QString("... (%1 more)").arg(hidden)} + parts.mid(parts.size() - keep);
+        }
+        s += "  " + parts.join(" -> ") + "\n";
     }
-    return parts.join(" -> ");
+    if (total > DAG_PATHS_SHOWN) s += "  ...\n";
+    return s;
 }
 
-void MainWindow::updateInfoForNode(FibNode* node, FibNode* parent) {
+void MainWindow::updateInfoForNode(NodeId node, NodeId parent) {
+    PROFILE_SCOPE("update info");
     QString s;
-    s += QString("Node: F(%1)\n").arg(node->n);
-    s += QString("Value: %1\n").arg(node->value);
-    s += QString("Depth: %1\n").arg(node->depth);
-    s += QString("Cached: %1\n").arg(node->isCached ? "Yes" : "No");
-    s += QString("Children: %1\n").arg((int)node->children.size());
-    if (parent) s += QString("Parent: F(%1)\n").arg(parent->n);
-    else s += QString("Parent: (root)\n");
+    s += QString("Node: %1\n").arg(callName(tree.rule, tree.n[node]));
+    if (tree.rule != RuleFibonacci) s += QString("Recurrence: %1\n").arg(recurrenceName(tree.rule));
+    s += QString("Value: %1\n").arg(QString::fromStdString(valueText(tree.rule, tree.n[node])));
+    s += QString("Depth: %1\n").arg(tree.depth[node]);
+    if (dagMode) {
+        // every caller, straight from the node's incidence list
+        s += QString("Calls: %1\n").arg(tree.n[node] >= 2 ? 2 : 0);
+        QStringList callers;
+        for (int i = 0; i < memoDag.callerCount(node); ++i) {
+            const MemoDag::Edge &e = memoDag.callerEdge(node, i);
+            callers << QString("F(%1)%2").arg(tree.n[e.caller]).arg(e.cached ? " (memo hit)" : "");
+        }
+        s += QString("Called by: %1\n").arg(callers.isEmpty() ? QString("(root)") : callers.join(", "));
+        s += callPathsText(node);
+    } else {
+        s += QString("Cached: %1\n").arg(tree.cached[node] ? "Yes" : "No");
+        if (!trace.inclusiveTicks.empty()) {
+            s += QString("Measured: %1 ns with its calls, %2 ns in itself\n")
+                     .arg(trace.ns(trace.inclusiveTicks[node]), 0, 'f', 0).arg(trace.ns(trace.exclusiveTicks[node]), 0, 'f', 0);
+        }
+        s += QString("Children: %1\n").arg(tree.childCount(node));
+        if (parent != NO_NODE) s += QString("Parent: %1\n").arg(callName(tree.rule, tree.n[parent]));
+        else s += QString("Parent: (root)\n");
 
-    // Add a helpful path from root to this node
-    s += QString("Path from root: %1\n").arg(pathToRoot(node));
+        // Add a helpful path from root to this node
+        s += QString("Path from root: %1\n").arg(pathToRoot(node));
+    }
 
-    s += QString("\nNodes revealed: %1 / %2\n").arg((int)nodeRevealIndex).arg((int)visitOrder.size());
+    const RevealTimeline &timeline = treeScene->timeline();
+    s += QString("\nStep %1 / %2 (%3)\n").arg(qulonglong(timeline.position())).arg(qulonglong(timeline.length()))
+             .arg(ui->comboSchedule->itemText(timeline.schedule()));
+    s += QString("Nodes revealed: %1 / %2\n").arg(qulonglong(timeline.visibleCount())).arg(qulonglong(tree.size()));
+    if (timeline.schedule() == ScheduleCallReturn && timeline.position() > 0) {
+        // the active frame is the node above, so its path from root is the call stack
+        const RevealTimeline::Event &e = timeline.event(timeline.position() - 1);
+        s += QString("Last event: %1 %2, call stack depth %3\n")
+                 .arg(e.call ? "call" : "return from", callName(tree.rule, tree.n[e.node])).arg(timeline.stackDepth(tree));
+    }
 
     // Provide a tiny performance hint for memo mode
-    if (ui->radioMemo->isChecked()) {
+    if (dagMode) {
+        s += "\nNote: each F(k) is computed once; dashed edges are answered from the memo table.\n";
+    } else if (treeMemo) {
         s += "\nNote: memoized mode uses cached subcalls.\n";
     }
 
+    setInfoText(s);
+}
+
+void MainWindow::updateInfoForImplicitNode(uint64_t index) {
+    PROFILE_SCOPE("update info");
+    const ImplicitFibTree &t = implicitView->tree();
+    ImplicitFibTree::Node node = t.at(index);
+
+    QStringList parts;
+    ImplicitFibTree::Node cur = t.root();
+    parts << QString("F(%1)").arg(cur.n);
+    for (int step : t.pathOf(index)) {
+        cur = t.child(cur, step);
+        parts << QString("F(%1)").arg(cur.n);
+    }
+
+    QString s;
+    s += QString("Node: F(%1)\n").arg(node.n);
+    s += QString("Value: %1\n").arg(QString::fromStdString(valueText(RuleFibonacci, node.n)));
+    s += QString("Depth: %1\n").arg(node.depth);
+    s += QString("Children: %1\n").arg(node.isLeaf() ? 0 : 2);
+    if (node.parent != ImplicitFibTree::NO_INDEX) s += QString("Parent: F(%1)\n").arg(node.parentN);
+    else s += QString("Parent: (root)\n");
+    s += QString("Preorder index: %1\n").arg(node.index);
+    s += QString("Path from root: %1\n").arg(parts.join(" -> "));
+    s += QString("\nNodes revealed: %1 / %2\n").arg(implicitView->revealedCount()).arg(t.nodeCount());
+    setInfoText(s);
+}
+
+void MainWindow::setInfoText(const QString &text) {
+    infoBody = text;
+    refreshInfoText();
+}
+
+void MainWindow::refreshInfoText() {
+    QString s = infoBody;
+    if (Profiler::enabled() && actProfilerSummary && actProfilerSummary->isChecked()) {
+        s += "\n---------------- Profiler ----------------\n";
+        s += QString::fromStdString(Profiler::summary());
+    }
+    // periodic refreshes should not scroll the panel back to the top
+    QScrollBar *bar = ui->infoText->verticalScrollBar();
+    const int scroll = bar->value();
     ui->infoText->setPlainText(s);
+    bar->setValue(scroll);
+}
+
+// ---------------- profiler ----------------
+void MainWindow::setProfilerEnabled(bool enabled) {
+    Profiler::setEnabled(enabled);
+    if (enabled) profilerTimer.start();
+    else profilerTimer.stop();
+    refreshInfoText();
+    ui->statusbar->showMessage(enabled ? "Profiler recording" : "Profiler stopped");
+}
+
+void MainWindow::exportTrace() {
+    QString path = QFileDialog::getSaveFileName(this, "Export Chrome trace", "fibonacci-trace.json",
+                                                "Trace event JSON (*.json)");
+    if (path.isEmpty()) return;
+    const std::string json = Profiler::chromeTrace();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json.data(), qint64(json.size())) != qint64(json.size())
+        || !file.commit()) {
+        QMessageBox::warning(this, "Export failed", QString("Could not write %1: %2").arg(path, file.errorString()));
+        return;
+    }
+    ui->statusbar->showMessage(QString("Trace written to %1 (open it in chrome://tracing or ui.perfetto.dev)").arg(path));
+}
+
+// ---------------- search and selection ----------------
+bool MainWindow::ensureNodeIndex() {
+    if (tree.empty()) return false;
+    if (!nodeIndex.isBuilt()) {
+        PROFILE_SCOPE("node index");
+        nodeIndex.build(tree, H_GAP, NODE_HALF_W, NODE_HALF_H);
+    }
+    return true;
+}
+
+void MainWindow::selectNode(NodeId node) {
+    treeScene->setHighlighted(node);
+    selectedNode = node;
+    if (node != NO_NODE) updateInfoForNode(node, tree.parent[node]);
+}
+
+void MainWindow::findNode() {
+    PROFILE_SCOPE("find node");
+    const QString query = ui->searchBox->text().trimmed();
+    std::vector<int> path;
+    uint64_t nth = 0;
+    if (query.isEmpty()) return;
+    if (!parseQuery(query, &path, &nth)) {
+        ui->statusbar->showMessage("Search for F(k), k#i (the i-th call of F(k)) or a path like 6/5/3");
+        return;
+    }
+    const bool implicit = renderMode == RenderImplicit;
+    if (!implicit && !ensureNodeIndex()) {
+        ui->statusbar->showMessage("Draw a tree first");
+        return;
+    }
+    const ImplicitFibTree &t = implicitView->tree();
+    const int rootN = implicit ? t.rootN() : tree.n[0];
+    const RecurrenceRule rule = implicit ? RuleFibonacci : tree.rule;
+    const int k = path.back();
+
+    // a path names one node; F(k) alone names its calls in preorder
+    uint64_t index = ImplicitFibTree::NO_INDEX; // implicit mode
+    NodeId node = NO_NODE;
+    QString found;
+    if (path.size() > 1) {
+        bool ok = path.front() == rootN;
+        ImplicitFibTree::Node cur = implicit ? t.root() : ImplicitFibTree::Node();
+        NodeId id = 0;
+        for (size_t i = 1; i < path.size() && ok; ++i) {
+            const int from = path[i - 1], to = path[i];
+            // trees are searched child by child below; the implicit tree and the DAG only know F(k)
+            ok = (!implicit && !dagMode) || (from >= 2 && (to == from - 1 || to == from - 2));
+            if (!ok) break;
+            if (implicit) {
+                cur = t.child(cur, from - to - 1);
+            } else if (!dagMode) {
+                // memo hits are leaves, so a path may end early in memoized trees
+                NodeId next = NO_NODE;
+                for (NodeId c = tree.firstChild[id]; c != NO_NODE && next == NO_NODE; c = tree.nextSibling[c]) {
+                    if (tree.n[c] == to) next = c;
+                }
+                ok = next != NO_NODE;
+                id = next;
+            }
+        }
+        if (!ok) {
+            ui->statusbar->showMessage(QString("No call path %1 in this tree").arg(query));
+            return;
+        }
+        index = cur.index;
+        node = dagMode ? nodeIndex.occurrence(k, 0) : id;
+        found = QString("%1 at depth %2").arg(callName(rule, k)).arg(int(path.size()) - 1);
+    } else {
+        const uint64_t count = implicit ? ImplicitFibTree::occurrences(rootN, k) : nodeIndex.occurrences(k);
+        if (count == 0) {
+            ui->statusbar->showMessage(QString("%1 is not called in this tree").arg(callName(rule, k)));
+            return;
+        }
+        uint64_t occurrence = nth > 0 ? nth - 1 : 0;
+        if (nth == 0 && query == lastQuery) occurrence = (lastOccurrence + 1) % count;
+        if (occurrence >= count) {
+            ui->statusbar->showMessage(QString("%1 is called only %2 times").arg(callName(rule, k)).arg(qulonglong(count)));
+            return;
+        }
+        lastOccurrence = occurrence;
+        index = implicit ? t.occurrence(k, occurrence) : ImplicitFibTree::NO_INDEX;
+        node = implicit ? NO_NODE : nodeIndex.occurrence(k, size_t(occurrence));
+        found = QString("%1: call %2 of %3").arg(callName(rule, k)).arg(qulonglong(occurrence + 1)).arg(qulonglong(count));
+    }
+    lastQuery = query;
+
+    bool shown;
+    if (implicit) {
+        implicitView->centerOn(index);
+        implicitView->setSelected(index);
+        updateInfoForImplicitNode(index);
+        shown = index < implicitView->revealedCount();
+    } else {
+        selectNode(node);
+        ui->graphicsView->centerOn(tree.x[node] * H_GAP, tree.y[node]);
+        virtualScene->scheduleRefresh();
+        shown = treeScene->revealed()[node] != 0;
+    }
+    ui->statusbar->showMessage(shown ? found : found + " (not revealed yet)");
+}
+
+// ---------------- limits ----------------
+void MainWindow::editMemoryBudget() {
+    const double mb = 1024.0 * 1024;
+    bool ok = false;
+    const int budget = QInputDialog::getInt(this, "Memory budget", "Memory a drawn tree may use (MB):",
+                                            int(governor.memoryBudget() / mb), 16, 1 << 22, 64, &ok);
+    if (!ok) return;
+    governor.setMemoryBudget(budget * mb);
+    // a smaller budget evicts stored subtrees right away, so the next plan sees the memory free
+    builder->setStoreLimit(size_t(governor.storeBudget()));
+    ui->statusbar->showMessage(QString("Memory budget: %1, of which stored subtrees may keep %2")
+                               .arg(ResourceGovernor::bytesText(budget * mb), ResourceGovernor::bytesText(governor.storeBudget())));
 }
 
 // ---------------- update Step/Skip button states ----------------
+bool MainWindow::hasUnrevealed() const {
+    if (renderMode == RenderImplicit) return implicitView->revealedCount() < implicitView->tree().nodeCount();
+    const RevealTimeline &timeline = treeScene->timeline();
+    return timeline.position() < timeline.length();
+}
+
 void MainWindow::updateStepSkipButtons() {
-    bool hasRemaining = nodeRevealIndex < visitOrder.size();
+    bool hasRemaining = hasUnrevealed();
     ui->btnStep->setEnabled(hasRemaining);
     ui->btnSkip->setEnabled(hasRemaining);
+    // the implicit view keeps a preorder counter instead of a timeline
+    const bool implicit = renderMode == RenderImplicit;
+    ui->btnBack->setEnabled(implicit ? implicitView->revealedCount() > 0 : treeScene->timeline().position() > 0);
+    ui->timelineSlider->setEnabled(!implicit && treeScene->timeline().length() > 0);
 }
 
 // ---------------- event filter for wheel (zoom) ----------------
 bool MainWindow::eventFilter(QObject *watched, QEvent *event) {
     // We installed the filter on the graphicsView viewport
+    if (watched == ui->graphicsView->viewport() && event->type() == QEvent::Paint && Profiler::enabled() && !paintingView) {
+        // one frame of whichever renderer is active, items included: deliver the paint
+        // inside a scope; the nested delivery passes through here untouched
+        PROFILE_SCOPE("paint view");
+        paintingView = true;
+        QCoreApplication::sendEvent(watched, event);
+        paintingView = false;
+        return true;
+    }
     if (watched == ui->graphicsView->viewport() && event->type() == QEvent::Wheel) {
         QWheelEvent *we = static_cast<QWheelEvent*>(event);
         QPoint numDegrees = we->angleDelta() / 8;
@@ -418,76 +774,363 @@ bool MainWindow::eventFilter(QObject *watched, QEvent *event) {
         if (deltaSteps != 0) {
             const double factor = std::pow(1.125, deltaSteps);
             ui->graphicsView->scale(factor, factor);
+            virtualScene->scheduleRefresh();
+            updateMiniMapView();
             return true; // we've handled it
         }
     }
+    if (watched == ui->graphicsView->viewport() && event->type() == QEvent::Resize) {
+        virtualScene->scheduleRefresh();
+        updateMiniMapView();
+    }
+    // a click without a drag selects the revealed node under the cursor; the view still pans
+    if (watched == ui->graphicsView->viewport() && event->type() == QEvent::MouseButtonPress) {
+        pressPos = static_cast<QMouseEvent*>(event)->position().toPoint();
+    }
+    if (watched == ui->graphicsView->viewport() && event->type() == QEvent::MouseButtonRelease) {
+        const QPoint pos = static_cast<QMouseEvent*>(event)->position().toPoint();
+        if ((pos - pressPos).manhattanLength() < QApplication::startDragDistance() && ensureNodeIndex()) {
+            const QPointF at = ui->graphicsView->mapToScene(pos);
+            const NodeId hit = nodeIndex.hitTest(tree, at.x(), at.y());
+            if (hit != NO_NODE && treeScene->revealed()[hit]) selectNode(hit);
+        }
+    }
     return QMainWindow::eventFilter(watched, event);
 }
 
 // ---------------- UI slot: Draw ----------------
 void MainWindow::on_btnDraw_clicked() {
     clearSceneAndMemory();
-    ui->infoText->clear();
+    setInfoText(QString());
 
     int n = ui->spinBoxN->value();
+    if (ui->radioValueOnly->isChecked()) {
+        showValueOnly(n);
+        return;
+    }
+    if (ui->radioMemoDag->isChecked()) {
+        showMemoDag(n);
+        return;
+    }
     bool isNaive = ui->radioNaive->isChecked();
-
-    // Safety
-    if (isNaive && n > 12) {
-        QMessageBox::warning(this, "Too large",
-                             "Naive recursion tree grows very fast. Please choose n <= 12 or use Memoized mode.");
+    const RecurrenceRule rule = selectedRule();
+    // the chosen renderer unless the prediction exceeds the budgets, then the next cheaper one
+    governor.setReservedBytes(double(builder->storeBytes()));
+    const ResourceGovernor::Plan plan = governor.plan(rule, n, isNaive, Strategy(ui->comboRenderer->currentIndex()));
+    predicted = plan.cost;
+    if (plan.strategy == StrategyValueOnly) {
+        showValueOnly(n, plan.reason);
         return;
     }
+    renderMode = static_cast<RenderMode>(plan.strategy);
 
-    FibNode* root = nullptr;
-    if (isNaive) {
-        root = buildNaiveFib(n);
-    } else {
-        std::unordered_map<int, FibNode*> memo;
-        root = buildMemoFib(n, memo);
+    ui->graphicsView->setVisible(renderMode != RenderImplicit);
+    implicitView->setVisible(renderMode == RenderImplicit);
+    if (renderMode == RenderImplicit) {
+        // nothing to build or lay out: every node is derived from its preorder index
+        implicitView->setTree(n);
+        bool animate = ui->checkBoxAnimate->isChecked();
+        implicitView->setRevealedCount(animate ? 1 : implicitView->tree().nodeCount());
+        stopSkip();
+        updateStepSkipButtons();
+        updateInfoForImplicitNode(0);
+        if (!plan.reason.isEmpty()) ui->statusbar->showMessage(plan.reason);
+        return;
     }
 
-    // layout
-    std::unordered_map<FibNode*, double> widths;
-    computeWidths(root, widths);
-    double cursor = 0.0;
-    assignPositions(root, cursor, 0, 1.0, V_GAP);
+    // the worker hands the finished tree to onTreeBuilt()
+    treeMemo = !isNaive;
+    setBuildUiVisible(true);
+    setInfoText(governor.describe(plan.cost));
+    ui->statusbar->showMessage(plan.reason.isEmpty()
+                               ? QString("Building %1 %2 tree for n = %3...")
+                                     .arg(isNaive ? "naive" : "memoized", recurrenceName(rule)).arg(n)
+                               : plan.reason);
+    builder->start(rule, n, isNaive);
+}
 
-    drawTree(root);
+void MainWindow::onTreeBuilt(std::shared_ptr<CallTree> built, double ms, SubtreeStore::Source source) {
+    tree = std::move(*built);
+    ui->statusbar->showMessage(QString("%1 nodes %2 in %3 ms (%4 threads), predicted %5 ms")
+                               .arg(qulonglong(tree.size())).arg(SubtreeStore::sourceName(source)).arg(ms, 0, 'f', 1)
+                               .arg(ui->radioNaive->isChecked() && tree.rule == RuleFibonacci ? builder->threadCount() : 1)
+                               .arg(predicted.buildMs, 0, 'f', 1));
+    drawTree();
+}
 
-    // fit view to content (if any)
-    if (!scene->items().isEmpty()) {
-        ui->graphicsView->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio);
-    }
+void MainWindow::cancelBuild() {
+    clearSceneAndMemory();
+    ui->statusbar->showMessage("Build cancelled");
+}
+
+void MainWindow::restartBuildIfRunning() {
+    // a new n while the old tree is still being built or populated replaces it
+    if (builder->isRunning() || populateTimer.isActive()) on_btnDraw_clicked();
+}
+
+void MainWindow::setBuildUiVisible(bool visible) {
+    buildProgress->setValue(0);
+    buildProgress->setVisible(visible);
+    btnCancelBuild->setVisible(visible);
 }
 
 // ---------------- Step: reveal a single node ----------------
 void MainWindow::on_btnStep_clicked() {
     // stop any running auto reveal
-    nodesTimer.stop();
-    skipMode = false;
-    nodesTimer.setInterval(normalRevealInterval);
+    stopSkip();
     on_showNextNode();
 }
 
 // ---------------- Skip: reveal all remaining (fast animation) ----------------
 void MainWindow::on_btnSkip_clicked() {
-    if (nodeRevealIndex >= visitOrder.size()) return;
+    if (!hasUnrevealed() || skipMode) return;
     skipMode = true;
-    nodesTimer.setInterval(fastRevealInterval);
-    nodesTimer.start();
+    skipFrom = renderMode == RenderImplicit ? implicitView->revealedCount() : treeScene->timeline().position();
+    skipClock.start();
+    animator->setFrameWork(true);
     // keep buttons enabled while running; they will be disabled when finished
 }
 
-// ---------------- small fib helpers ----------------
-unsigned long long MainWindow::fib_value_naive(int n) {
-    if (n <= 1) return n;
-    return fib_value_naive(n-1) + fib_value_naive(n-2);
+// ---------------- Back and the slider: rewind the timeline ----------------
+void MainWindow::on_btnBack_clicked() {
+    stopSkip();
+    if (renderMode == RenderImplicit) {
+        const uint64_t count = implicitView->revealedCount();
+        if (count == 0) return;
+        implicitView->setRevealedCount(count - 1);
+        updateInfoForImplicitNode(count >= 2 ? count - 2 : 0);
+    } else {
+        if (treeScene->timeline().position() == 0) return;
+        seekTimeline(treeScene->timeline().position() - 1, 0);
+        showActiveNode();
+    }
+    updateStepSkipButtons();
 }
 
-unsigned long long MainWindow::fib_value_dp(int n) {
-    if (n <= 1) return n;
-    unsigned long long a = 0, b = 1;
-    for (int i = 2; i <= n; ++i) { unsigned long long c = a + b; a = b; b = c; }
-    return b;
+void MainWindow::seekFromSlider(int step) {
+    if (renderMode == RenderImplicit || treeScene->timeline().length() == 0) return;
+    stopSkip();
+    seekTimeline(size_t(step), 0);
+    showActiveNode();
+    updateStepSkipButtons();
+}
+
+void MainWindow::changeSchedule() {
+    const RevealTimeline &timeline = treeScene->timeline();
+    // applies to the next tree while one is being built or populated
+    if (renderMode == RenderImplicit || timeline.length() == 0 || populateTimer.isActive()) return;
+    stopSkip();
+    // the same share of the new schedule: rewind, rebuild, then seek forward again
+    const double done = double(timeline.position()) / timeline.length();
+    seekTimeline(0, 0);
+    treeScene->startReveal(RevealSchedule(ui->comboSchedule->currentIndex()));
+    seekTimeline(size_t(std::llround(done * timeline.length())), 0);
+    showActiveNode();
+    updateStepSkipButtons();
+}
+
+// ---------------- tree files ----------------
+void MainWindow::openTree() {
+    QString path = QFileDialog::getOpenFileName(this, "Open call tree", QString(), TREE_FILE_FILTER);
+    if (path.isEmpty()) return;
+    clearSceneAndMemory();
+    setInfoText(QString());
+
+    QElapsedTimer timer;
+    timer.start();
+    TreeFileInfo info;
+    QString error;
+    if (!loadTreeFile(path, tree, &info, &error)) {
+        QMessageBox::warning(this, "Open failed", error);
+        return;
+    }
+    const double loadMs = timer.nsecsElapsed() / 1e6;
+    treeMemo = info.memo;
+
+    // the file already holds the layout, so only a renderer is needed; the implicit one builds its own tree
+    governor.setReservedBytes(double(builder->storeBytes()));
+    const ResourceGovernor::Plan plan = governor.planLoaded(tree.size(), Strategy(ui->comboRenderer->currentIndex()));
+    predicted = plan.cost;
+    renderMode = static_cast<RenderMode>(plan.strategy);
+    implicitView->hide();
+    ui->graphicsView->show();
+    ui->comboRecurrence->setCurrentIndex(info.rule);
+    (info.memo ? ui->radioMemo : ui->radioNaive)->setChecked(true);
+    updateRangeForMode();
+    {
+        QSignalBlocker block(ui->spinBoxN);
+        ui->spinBoxN->setValue(info.rootN);
+    }
+    ui->statusbar->showMessage(QString("Opened %1 nodes in %2 ms%3").arg(qulonglong(tree.size())).arg(loadMs, 0, 'f', 1)
+                               .arg(plan.reason.isEmpty() ? QString() : "; " + plan.reason));
+    drawTree();
+}
+
+bool MainWindow::canWriteTree(const QString &title) {
+    if (tree.empty() || populateTimer.isActive()) {
+        QMessageBox::information(this, title, "Draw or open a tree first.");
+        return false;
+    }
+    if (dagMode) {
+        QMessageBox::information(this, title, "Tree files and exports hold trees; the DAG's extra edges would be lost. "
+                                              "Draw the memoized tree instead.");
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::saveTree() {
+    if (!canWriteTree("Save tree")) return;
+    QString path = QFileDialog::getSaveFileName(this, "Save call tree", QString("fib%1.fibtree").arg(tree.n[0]),
+                                                TREE_FILE_FILTER);
+    if (path.isEmpty()) return;
+    QString error;
+    if (!saveTreeFile(path, tree, treeMemo, V_GAP, &error)) {
+        QMessageBox::warning(this, "Save failed", error);
+        return;
+    }
+    ui->statusbar->showMessage(QString("Saved %1 nodes to %2").arg(qulonglong(tree.size())).arg(path));
+}
+
+void MainWindow::exportSvg() {
+    if (!canWriteTree("Export SVG")) return;
+    QString path = QFileDialog::getSaveFileName(this, "Export SVG", QString("fib%1.svg").arg(tree.n[0]), "SVG (*.svg)");
+    if (path.isEmpty()) return;
+    QString error;
+    if (!exportTreeSvg(tree, path, &error)) QMessageBox::warning(this, "Export failed", error);
+    else ui->statusbar->showMessage(QString("Exported %1").arg(path));
+}
+
+void MainWindow::exportPng() {
+    if (!canWriteTree("Export PNG")) return;
+    QString path = QFileDialog::getSaveFileName(this, "Export PNG", QString("fib%1.png").arg(tree.n[0]), "PNG (*.png)");
+    if (path.isEmpty()) return;
+    QString error;
+    if (!exportTreePng(tree, path, PNG_EXPORT_MAX_SIDE, &error)) QMessageBox::warning(this, "Export failed", error);
+    else ui->statusbar->showMessage(QString("Exported %1").arg(path));
+}
+
+// ---------------- n range per mode ----------------
+RecurrenceRule MainWindow::selectedRule() const {
+    return RecurrenceRule(std::max(0, ui->comboRecurrence->currentIndex()));
+}
+
+void MainWindow::updateRangeForMode() {
+    // the memo DAG is F(k) only, and the other rules have values up to their last 64-bit one
+    const RecurrenceRule rule = selectedRule();
+    ui->radioMemoDag->setEnabled(rule == RuleFibonacci);
+    if (rule != RuleFibonacci && ui->radioMemoDag->isChecked()) ui->radioMemo->setChecked(true);
+    int maxN = ui->radioValueOnly->isChecked() ? MAX_VALUE_ONLY_N
+             : ui->radioMemo->isChecked() ? MAX_MEMO_N
+             : ui->radioMemoDag->isChecked() ? MAX_MEMO_DAG_N : ImplicitFibTree::MAX_N;
+    if (rule != RuleFibonacci) maxN = std::min(maxN, recurrenceMaxN(rule));
+    ui->spinBoxN->setMaximum(maxN);
+}
+
+// ---------------- memo DAG: every F(k) once, with all its callers ----------------
+void MainWindow::showMemoDag(int n) {
+    // n + 1 nodes and 2(n - 1) edges: built right here and drawn as scene items
+    renderMode = RenderItems;
+    implicitView->hide();
+    ui->graphicsView->show();
+    tree.buildMemoDag(n);
+    MemoDag::layout(tree, V_GAP);
+    memoDag.build(tree);
+    dagMode = true;
+    treeMemo = true;
+    ui->statusbar->showMessage(QString("Memo DAG for n = %1: %2 nodes, %3 edges")
+                               .arg(n).arg(qulonglong(tree.size())).arg(qulonglong(memoDag.edges.size())));
+    drawTree();
+}
+
+// ---------------- traced runs ----------------
+void MainWindow::traceRun(TraceAlgorithm algorithm) {
+    const int n = ui->spinBoxN->value();
+    const uint64_t calls = CallTracer::callCount(algorithm, n);
+    if (calls > MAX_TRACE_CALLS || CallTracer::recursionDepth(algorithm, n) > MAX_TRACE_DEPTH) {
+        QMessageBox::information(this, "Trace", QString("The %1 for n = %2 makes %3 calls, %4 deep; traces are limited "
+                                                        "to %5 calls and a depth of %6.")
+                                 .arg(QString(CallTracer::algorithmName(algorithm))).arg(n).arg(qulonglong(calls))
+                                 .arg(CallTracer::recursionDepth(algorithm, n)).arg(qulonglong(MAX_TRACE_CALLS))
+                                 .arg(MAX_TRACE_DEPTH));
+        return;
+    }
+    clearSceneAndMemory();
+    setInfoText(QString());
+
+    // the run is short next to drawing what it recorded, so it stays on this thread
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    CallTracer::trace(algorithm, n, V_GAP, &trace);
+    QApplication::restoreOverrideCursor();
+    tree = std::move(trace.tree);
+    treeMemo = algorithm == TraceMemo;
+
+    // already laid out, so only a renderer is needed, as for opened files
+    governor.setReservedBytes(double(builder->storeBytes()));
+    const ResourceGovernor::Plan plan = governor.planLoaded(tree.size(), Strategy(ui->comboRenderer->currentIndex()));
+    predicted = plan.cost;
+    renderMode = static_cast<RenderMode>(plan.strategy);
+    implicitView->hide();
+    ui->graphicsView->show();
+    const double overheadNs = std::max(0.0, (trace.tracedMs - trace.untracedMs) * 1e6 / std::max<uint64_t>(1, trace.events));
+    ui->statusbar->showMessage(QString("Traced %1 calls of the %2 (%3 events): %4 ms, %5 ms without probes, "
+                                       "about %6 ns per event%7")
+                               .arg(qulonglong(tree.size())).arg(QString(CallTracer::algorithmName(algorithm)))
+                               .arg(qulonglong(trace.events)).arg(trace.tracedMs, 0, 'f', 2)
+                               .arg(trace.untracedMs, 0, 'f', 2).arg(overheadNs, 0, 'f', 1)
+                               .arg(plan.reason.isEmpty() ? QString() : "; " + plan.reason));
+    drawTree();
+}
+
+// ---------------- F(n) only: value and timings, no tree ----------------
+void MainWindow::showValueOnly(int n, const QString &note) {
+    PROFILE_SCOPE("value only");
+    // the tree views stay empty; Step/Skip were disabled by clearSceneAndMemory()
+    renderMode = RenderItems;
+    implicitView->hide();
+    ui->graphicsView->show();
+
+    const RecurrenceRule rule = selectedRule();
+    if (rule != RuleFibonacci) {
+        // the other rules stop where their values leave 64 bits, so this is a table lookup
+        QString s = QString("%1 = %2\n%3 recurrence, from its compile-time table.\n")
+                        .arg(callName(rule, n), QString::fromStdString(valueText(rule, n)), recurrenceName(rule));
+        if (!note.isEmpty()) s += "\n" + note + ".\n";
+        setInfoText(s);
+        ui->statusbar->showMessage(note.isEmpty() ? QString("%1 looked up").arg(callName(rule, n)) : note);
+        return;
+    }
+
+    // F(1e7) takes over a second; the worker hands the value to onValueComputed()
+    valueNote = note;
+    setBuildUiVisible(true);
+    setInfoText(QString("Computing F(%1)...\n").arg(n));
+    ui->statusbar->showMessage(note.isEmpty() ? QString("Computing F(%1)...").arg(n) : note);
+    builder->startValue(n, n <= MAX_LINEAR_COMPARE_N);
+}
+
+void MainWindow::onValueComputed(std::shared_ptr<const FibValueResult> result) {
+    setBuildUiVisible(false);
+    const FibValueResult &r = *result;
+    QString s;
+    s += QString("F(%1) = %2\n").arg(r.n).arg(QString::fromStdString(r.text));
+    s += QString("Digits: %1\n").arg(qulonglong(r.digits));
+    s += QString("Bits: %1\n").arg(qulonglong(r.bits));
+    s += QString("\nFast doubling: %1 ms\n").arg(r.doublingMs, 0, 'f', 3);
+
+    if (r.linearMs >= 0) {
+        s += QString("Linear DP loop: %1 ms").arg(r.linearMs, 0, 'f', 3);
+        if (r.doublingMs > 0) s += QString(" (%1x slower)").arg(r.linearMs / r.doublingMs, 0, 'f', 1);
+        s += "\n";
+        if (!r.agree) s += "Warning: the two methods disagree!\n";
+    } else {
+        s += QString("Linear DP loop: skipped above n = %1\n").arg(MAX_LINEAR_COMPARE_N);
+    }
+    if (!valueNote.isEmpty()) s += "\n" + valueNote + ".\n";
+
+    setInfoText(s);
+    ui->statusbar->showMessage(valueNote.isEmpty()
+                               ? QString("F(%1) computed in %2 ms").arg(r.n).arg(r.doublingMs, 0, 'f', 3)
+                               : valueNote);
+    valueNote.clear();
 }
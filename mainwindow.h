@@ -6,38 +6,33 @@
 #include <QGraphicsTextItem>
 #include <QGraphicsScene>
 #include <QTimer>
-#include <QVariantAnimation>
+#include <QElapsedTimer>
+#include <memory>
 #include <vector>
-#include <unordered_map>
+#include "calltracer.h"
+#include "calltree.h"
+#include "memodag.h"
+#include "nodeindex.h"
+#include "resourcegovernor.h"
+#include "revealtimeline.h"
+#include "subtreestore.h"
+#include "treescene.h"
+
+class VirtualTreeScene;
+class ImplicitTreeView;
+class TreeBuilder;
+class RevealAnimator;
+class AlgoBenchPanel;
+class MiniMap;
+class QProgressBar;
+class QPushButton;
+class QAction;
+struct FibValueResult;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-// Data node for the call tree
-struct FibNode {
-    int n;
-    long long value = 0;
-    bool isCached = false;
-    std::vector<FibNode*> children;
-    double x = 0; // logical x (units)
-    double y = 0; // pixel y
-    int depth = 0;
-    FibNode(int _n) : n(_n) {}
-};
-
-class NodeItem : public QGraphicsEllipseItem {
-public:
-    explicit NodeItem(FibNode* node, QGraphicsItem* parent = nullptr);
-
-    FibNode* nodePtr;
-    QGraphicsTextItem* label;
-    QGraphicsTextItem* subLabel; // for value/extra
-
-    void setHighlighted(bool on);
-    void applyStyle();
-};
-
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -55,48 +50,97 @@ private slots:
 
     void on_btnStep_clicked();
     void on_btnSkip_clicked();
+    void on_btnBack_clicked();
+    void seekFromSlider(int step);
+    void changeSchedule();
+    void updateRangeForMode();
+    void onTreeBuilt(std::shared_ptr<CallTree> built, double ms, SubtreeStore::Source source);
+    void onValueComputed(std::shared_ptr<const FibValueResult> result);
+    void cancelBuild();
+    void restartBuildIfRunning();
+    void populateSceneItems();
+    void onRevealFrame();
+    void refreshInfoText();
+    void setProfilerEnabled(bool enabled);
+    void exportTrace();
+    void openTree();
+    void saveTree();
+    void exportSvg();
+    void exportPng();
+    void findNode();
+    void editMemoryBudget();
 
 private:
     Ui::MainWindow *ui;
     QGraphicsScene *scene = nullptr;
-    std::vector<FibNode*> allNodes;
-    std::unordered_map<FibNode*, NodeItem*> nodeItems;
-
-    std::vector<QGraphicsLineItem*> edges;
-    std::vector<std::pair<FibNode*, FibNode*>> edgePairs;
-    std::unordered_map<FibNode*, FibNode*> parentMap;
+    CallTree tree;                    // arena holding every node of the current tree
+    bool treeMemo = false;            // tree is the memoized one (saved with it)
+    bool dagMode = false;             // tree holds the memo DAG's nodes; edges come from memoDag
+    MemoDag memoDag;
+    CallTrace trace;                  // times of a traced run; its tree was moved into tree
+
+    RenderMode renderMode = RenderItems;
+    VirtualTreeScene *virtualScene = nullptr;
+    TreeScene *treeScene = nullptr;   // items and reveal of tree on scene (all but RenderImplicit)
+    ImplicitTreeView *implicitView = nullptr;
+
+    TreeBuilder *builder = nullptr;
+    QProgressBar *buildProgress = nullptr;
+    QPushButton *btnCancelBuild = nullptr;
+    QTimer populateTimer;     // drives populateSceneItems() slices
 
     QTimer animTimer;        // kept for compatibility
-    int animIndex = 0;
-    std::vector<NodeItem*> visitOrder;
-
-    QTimer nodesTimer;       // reveal timer
-    int nodeRevealIndex = 0;
+    size_t animIndex = 0;
 
-    int normalRevealInterval = 160; // ms
-    int fastRevealInterval = 60;    // ms
+    RevealAnimator *animator = nullptr; // pop-ins and Skip, once per display frame
     bool skipMode = false;
-
-    // Build recursion trees
-    FibNode* buildNaiveFib(int n);
-    FibNode* buildMemoFib(int n, std::unordered_map<int, FibNode*>& memo);
-
-    // Layout
-    double computeWidths(FibNode* node, std::unordered_map<FibNode*, double>& widths);
-    void assignPositions(FibNode* node, double &cursorX, int depth, double horizUnit, double vertGap);
+    QElapsedTimer skipClock;
+    uint64_t skipFrom = 0;              // timeline step (implicit: nodes revealed) when Skip was pressed
+
+    ResourceGovernor governor;          // picks the renderer a tree can afford
+    CostEstimate predicted;             // of the tree being built or shown
+    QString valueNote;                  // appended to the value-only result when it arrives
+    NodeIndex nodeIndex;                // occurrences and hit tests, built on first use
+    NodeId selectedNode = NO_NODE;
+    QString lastQuery;                  // Enter on the same F(k) steps through its calls
+    uint64_t lastOccurrence = 0;
+    NodeId pathNode = NO_NODE;          // pathToRoot() cache
+    QString pathText;
+    QPoint pressPos;                    // clicks select, drags pan
+    bool paintingView = false;          // eventFilter() is delivering a viewport paint itself
+
+    QString infoBody;                   // info panel text without the profiler section
+    AlgoBenchPanel *algoBenchPanel = nullptr; // created on first use
+    MiniMap *miniMap = nullptr;         // overview dock; follows the reveal and the view
+    QAction *actProfilerSummary = nullptr;
+    QTimer profilerTimer;               // refreshes the profiler section while recording
 
     // Drawing & helpers
-    void drawTree(FibNode* root);
+    void drawTree();
+    void finishDraw();
+    void setBuildUiVisible(bool visible);
+    void seekTimeline(size_t step, int popIns);
+    void updateTimelineUi();
+    void showActiveNode();
+    void updateMiniMapView();
     void clearSceneAndMemory();
-    void collectVisitOrder(FibNode* node);
-
-    unsigned long long fib_value_naive(int n);
-    unsigned long long fib_value_dp(int n);
 
-    void revealNodeAtIndex(size_t idx);
-    void updateInfoForNode(FibNode* node, FibNode* parent);
+    void stopSkip();
+    void setInfoText(const QString &text);
+    void updateInfoForNode(NodeId node, NodeId parent);
     void updateStepSkipButtons();
-    QString pathToRoot(FibNode* node);
+    bool hasUnrevealed() const;
+    void showNextImplicitNode();
+    void updateInfoForImplicitNode(uint64_t index);
+    RecurrenceRule selectedRule() const;
+    void showValueOnly(int n, const QString &note = QString());
+    void showMemoDag(int n);
+    void traceRun(TraceAlgorithm algorithm);
+    QString callPathsText(NodeId node);
+    bool canWriteTree(const QString &title);
+    QString pathToRoot(NodeId node);
+    bool ensureNodeIndex();
+    void selectNode(NodeId node);
 };
 
 #endif // MAINWINDOW_H
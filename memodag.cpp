@@ -0,0 +1,76 @@
+#include "memodag.h"
+#include <algorithm>
+
+void MemoDag::build(const CallTree& tree) {
+    clear();
+    const size_t count = tree.size();
+    if (count == 0) return;
+    const int fibN = tree.n[0];
+    auto idOf = [fibN](int k) { return NodeId(fibN - k); };
+
+    // ids increase from callers to callees, so one pass in id order sees every caller first
+    edges.reserve(count > 1 ? 2 * (count - 2) : 0);
+    for (NodeId v = 0; v < count; ++v) {
+        const int k = tree.n[v];
+        if (k < 2) continue;
+        edges.push_back({v, idOf(k - 1), false});
+        edges.push_back({v, idOf(k - 2), k >= 3}); // F(k-2) is already memoized for k >= 3
+    }
+
+    // caller lists (CSR): count, prefix sum, fill
+    callerOffsets.assign(count + 1, 0);
+    for (const Edge &e : edges) ++callerOffsets[e.callee + 1];
+    for (size_t v = 0; v < count; ++v) callerOffsets[v + 1] += callerOffsets[v];
+    callerEdges.resize(edges.size());
+    std::vector<std::uint32_t> fill(callerOffsets.begin(), callerOffsets.end() - 1);
+    for (std::uint32_t i = 0; i < edges.size(); ++i) callerEdges[fill[edges[i].callee]++] = i;
+
+    pathCounts.assign(count, 0);
+    pathCounts[0] = 1;
+    for (const Edge &e : edges) {
+        std::uint64_t &c = pathCounts[e.callee];
+        c = pathCounts[e.caller] > UINT64_MAX - c ? UINT64_MAX : c + pathCounts[e.caller];
+    }
+}
+
+void MemoDag::clear() {
+    edges.clear();
+    callerOffsets.clear();
+    callerEdges.clear();
+    pathCounts.clear();
+}
+
+std::vector<std::vector<NodeId>> MemoDag::pathsToRoot(NodeId v, size_t limit) const {
+    // depth-first walk up the caller lists; path holds the nodes from v upwards
+    std::vector<std::vector<NodeId>> paths;
+    std::vector<NodeId> path{v};
+    std::vector<int> nextCaller{0};
+    while (!path.empty() && paths.size() < limit) {
+        NodeId cur = path.back();
+        if (cur == 0) {
+            paths.emplace_back(path.rbegin(), path.rend());
+            path.pop_back();
+            nextCaller.pop_back();
+            continue;
+        }
+        int &i = nextCaller.back();
+        if (i == callerCount(cur)) {
+            path.pop_back();
+            nextCaller.pop_back();
+            continue;
+        }
+        path.push_back(callerEdge(cur, i++).caller);
+        nextCaller.push_back(0);
+    }
+    return paths;
+}
+
+void MemoDag::layout(CallTree& tree, double vertGap) {
+    if (tree.empty()) return;
+    const int fibN = tree.n[0];
+    for (NodeId v = 0; v < tree.size(); ++v) {
+        const int k = tree.n[v];
+        tree.x[v] = k % 2;
+        tree.y[v] = (fibN - k) * vertGap;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef MEMODAG_H
+#define MEMODAG_H
+
+#include <cstdint>
+#include <vector>
+#include "calltree.h"
+
+// The memoized recursion as the DAG it really is. The nodes are those of
+// CallTree::buildMemoDag (F(k) has id n - k); every F(k), k >= 2, contributes its two calls
+// as edges, so F(k-2) has both F(k-1) and F(k) as callers. Everything is O(n).
+struct MemoDag {
+    struct Edge {
+        NodeId caller;
+        NodeId callee;
+        bool cached; // answered from the memo table
+    };
+    std::vector<Edge> edges;
+    // incoming calls of v: edges[callerEdges[i]] for i in [callerOffsets[v], callerOffsets[v + 1])
+    std::vector<std::uint32_t> callerOffsets;
+    std::vector<std::uint32_t> callerEdges;
+    // number of call paths from the root to each node, saturating at UINT64_MAX
+    std::vector<std::uint64_t> pathCounts;
+
+    void build(const CallTree& tree);
+    void clear();
+    bool empty() const { return edges.empty() && pathCounts.empty(); }
+
+    int callerCount(NodeId v) const { return int(callerOffsets[v + 1] - callerOffsets[v]); }
+    const Edge& callerEdge(NodeId v, int i) const { return edges[callerEdges[callerOffsets[v] + i]]; }
+    // up to limit call paths from the root to v, root first, found through the caller lists
+    std::vector<std::vector<NodeId>> pathsToRoot(NodeId v, size_t limit) const;
+
+    // F(k) on layer n - k, alternating between two columns so no edge passes through a node
+    static void layout(CallTree& tree, double vertGap);
+};
+
+#endif // MEMODAG_H
@@ -0,0 +1,205 @@
+#include "minimap.h"
+#include "nodeitem.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <algorithm>
+
+// pixel grid of the overview; the widget stretches it to its own size
+static const int MAP_W = 256;
+static const int MAP_H = 160;
+static const int MAP_MARGIN = 4;
+// changes applied pixel by pixel on the GUI thread; more start a background count
+static const size_t BULK_CHANGES = 65536;
+// smallest side of the drawn view rect, so it stays grabbable when the view is zoomed in
+static const double MIN_VIEW_RECT_PX = 6.0;
+static const QColor BACKGROUND(15, 23, 36);
+static const QColor LAID_OUT(55, 66, 90);
+static const QColor REVEALED(20, 184, 166);
+
+MiniMap::MiniMap(QWidget* parent) : QWidget(parent) {
+    // one count at a time; it is restarted rather than run alongside another
+    pool.setMaxThreadCount(1);
+    setMinimumSize(120, 80);
+}
+
+MiniMap::~MiniMap() {
+    clear();
+}
+
+int MiniMap::pixelOf(const QRectF& b, double sceneX, double sceneY) {
+    const int px = std::clamp(int((sceneX - b.left()) / b.width() * MAP_W), 0, MAP_W - 1);
+    const int py = std::clamp(int((sceneY - b.top()) / b.height() * MAP_H), 0, MAP_H - 1);
+    return py * MAP_W + px;
+}
+
+// ---------------- tree ----------------
+void MiniMap::setTree(const CallTree* t, const std::vector<std::uint8_t>* rev) {
+    clear();
+    if (!t || t->empty()) return;
+    tree = t;
+    revealed = rev;
+    startCount();
+}
+
+void MiniMap::clear() {
+    if (running) {
+        running->cancel.store(true);
+        pool.waitForDone();
+        running.reset();
+    }
+    tree = nullptr;
+    revealed = nullptr;
+    pending.clear();
+    recount = false;
+    bounds = QRectF();
+    mirror = std::vector<std::uint8_t>();
+    laidOut.clear();
+    revealedCount.clear();
+    image = QImage();
+    update();
+}
+
+void MiniMap::startCount() {
+    if (running) running->cancel.store(true);
+    auto count = std::make_shared<Count>();
+    count->shown = *revealed; // snapshot: the GUI keeps revealing while this runs
+    running = count;
+    pending.clear();
+    recount = false;
+
+    const CallTree *t = tree;
+    pool.start([this, count, t]() {
+        auto [minX, maxX] = std::minmax_element(t->x.begin(), t->x.end());
+        const double maxY = *std::max_element(t->y.begin(), t->y.end());
+        const QRectF b(*minX * H_GAP - NODE_HALF_W, -NODE_HALF_H,
+                       (*maxX - *minX) * H_GAP + 2 * NODE_HALF_W, maxY + 2 * NODE_HALF_H);
+        count->laidOut.assign(size_t(MAP_W) * MAP_H, 0);
+        count->revealedCount.assign(size_t(MAP_W) * MAP_H, 0);
+        for (size_t v = 0; v < t->size(); ++v) {
+            if ((v & 0xFFFF) == 0 && count->cancel.load(std::memory_order_relaxed)) return;
+            const int p = pixelOf(b, t->x[v] * H_GAP, t->y[v]);
+            ++count->laidOut[p];
+            count->revealedCount[p] += count->shown[v] ? 1 : 0;
+        }
+        count->bounds = b;
+        QMetaObject::invokeMethod(this, [this, count]() { countDone(count); }, Qt::QueuedConnection);
+    });
+}
+
+void MiniMap::countDone(const std::shared_ptr<Count>& count) {
+    if (count != running) return; // superseded or cleared
+    running.reset();
+    bounds = count->bounds;
+    mirror = std::move(count->shown);
+    laidOut = std::move(count->laidOut);
+    revealedCount = std::move(count->revealedCount);
+    image = QImage(MAP_W, MAP_H, QImage::Format_RGB32);
+    for (int p = 0; p < MAP_W * MAP_H; ++p) paintPixel(p);
+
+    // what changed meanwhile is compared against the snapshot just counted
+    if (recount) {
+        startCount();
+    } else {
+        for (NodeId v : pending) applyChange(v);
+        pending.clear();
+    }
+    update();
+}
+
+// ---------------- reveal changes ----------------
+void MiniMap::nodesChanged(const std::vector<NodeId>& nodes) {
+    if (!tree || nodes.empty()) return;
+    if (running) {
+        if (recount || pending.size() + nodes.size() > BULK_CHANGES) recount = true;
+        else pending.insert(pending.end(), nodes.begin(), nodes.end());
+        return;
+    }
+    if (nodes.size() > BULK_CHANGES) {
+        startCount();
+        return;
+    }
+    for (NodeId v : nodes) applyChange(v);
+    update();
+}
+
+void MiniMap::applyChange(NodeId node) {
+    const std::uint8_t now = (*revealed)[node] ? 1 : 0;
+    if (mirror[node] == now) return;
+    mirror[node] = now;
+    const int p = pixelOf(bounds, tree->x[node] * H_GAP, tree->y[node]);
+    if (now) ++revealedCount[p];
+    else --revealedCount[p];
+    paintPixel(p);
+}
+
+void MiniMap::paintPixel(int p) {
+    QColor color = BACKGROUND;
+    if (revealedCount[p] > 0) {
+        // a single revealed node already stands out from a crowded pixel
+        const double share = 0.35 + 0.65 * double(revealedCount[p]) / laidOut[p];
+        color = QColor::fromRgbF(LAID_OUT.redF() + (REVEALED.redF() - LAID_OUT.redF()) * share,
+                                 LAID_OUT.greenF() + (REVEALED.greenF() - LAID_OUT.greenF()) * share,
+                                 LAID_OUT.blueF() + (REVEALED.blueF() - LAID_OUT.blueF()) * share);
+    } else if (laidOut[p] > 0) {
+        color = LAID_OUT;
+    }
+    image.setPixel(p % MAP_W, p / MAP_W, color.rgb());
+}
+
+// ---------------- view ----------------
+void MiniMap::setViewRect(const QRectF& sceneRect) {
+    if (sceneRect == viewRect) return;
+    viewRect = sceneRect;
+    update();
+}
+
+QRectF MiniMap::mapRect() const {
+    return QRectF(rect()).adjusted(MAP_MARGIN, MAP_MARGIN, -MAP_MARGIN, -MAP_MARGIN);
+}
+
+QPointF MiniMap::toScene(const QPointF& w) const {
+    const QRectF m = mapRect();
+    return QPointF(bounds.left() + (w.x() - m.left()) / m.width() * bounds.width(),
+                   bounds.top() + (w.y() - m.top()) / m.height() * bounds.height());
+}
+
+QPointF MiniMap::toWidget(const QPointF& s) const {
+    const QRectF m = mapRect();
+    return QPointF(m.left() + (s.x() - bounds.left()) / bounds.width() * m.width(),
+                   m.top() + (s.y() - bounds.top()) / bounds.height() * m.height());
+}
+
+void MiniMap::paintEvent(QPaintEvent*) {
+    QPainter p(this);
+    p.fillRect(rect(), BACKGROUND);
+    if (image.isNull()) {
+        p.setPen(QColor(180, 190, 205));
+        p.drawText(rect(), Qt::AlignCenter, tree ? "Counting..." : "No tree");
+        return;
+    }
+    p.drawImage(mapRect(), image); // nearest neighbour keeps single nodes visible
+
+    if (viewRect.isEmpty()) return;
+    QRectF r = QRectF(toWidget(viewRect.topLeft()), toWidget(viewRect.bottomRight())).intersected(mapRect());
+    if (r.isEmpty()) return;
+    const QPointF center = r.center();
+    r.setWidth(std::max(r.width(), MIN_VIEW_RECT_PX));
+    r.setHeight(std::max(r.height(), MIN_VIEW_RECT_PX));
+    r.moveCenter(center);
+    p.setPen(QPen(QColor(255, 159, 67), 1.5));
+    p.setBrush(QColor(255, 159, 67, 40));
+    p.drawRect(r);
+}
+
+void MiniMap::mousePressEvent(QMouseEvent* event) {
+    if (image.isNull() || event->button() != Qt::LeftButton) return;
+    const QPointF at = toScene(event->position());
+    // grabbing the rect drags it; a click elsewhere centers the view there
+    dragOffset = viewRect.contains(at) ? viewRect.center() - at : QPointF();
+    emit centerRequested(at + dragOffset);
+}
+
+void MiniMap::mouseMoveEvent(QMouseEvent* event) {
+    if (image.isNull() || !(event->buttons() & Qt::LeftButton)) return;
+    emit centerRequested(toScene(event->position()) + dragOffset);
+}
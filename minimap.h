@@ -0,0 +1,80 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <QImage>
+#include <QRectF>
+#include <QThreadPool>
+#include <QWidget>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "calltree.h"
+
+// Overview of the whole tree layout: a small image with one pixel per layout cell, dim where
+// nodes are laid out and bright where they are revealed, and the main view's visible rect on top.
+// The image is counted on a thread pool after a new tree or a bulk reveal; single reveals adjust
+// a pixel's counts on the GUI thread. Clicks and drags only ask the owner to center the view.
+class MiniMap : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit MiniMap(QWidget* parent = nullptr);
+    ~MiniMap() override; // waits for a count still running
+
+    // tree and revealed stay owned by the caller and must outlive clear() or the next setTree()
+    void setTree(const CallTree* tree, const std::vector<std::uint8_t>* revealed);
+    void clear();
+    // the reveal state of these nodes changed; many at once recount in the background
+    void nodesChanged(const std::vector<NodeId>& nodes);
+    // scene rect the main view currently shows
+    void setViewRect(const QRectF& sceneRect);
+
+    QSize sizeHint() const override { return QSize(260, 180); }
+
+signals:
+    void centerRequested(const QPointF& scenePos);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+
+private:
+    // one background count of every node into the pixel grid
+    struct Count {
+        std::atomic<bool> cancel{false};
+        std::vector<std::uint8_t> shown; // reveal state counted, becomes the mirror below
+        QRectF bounds;
+        std::vector<std::uint32_t> laidOut, revealedCount;
+    };
+    const CallTree* tree = nullptr;
+    const std::vector<std::uint8_t>* revealed = nullptr;
+    std::shared_ptr<Count> running;
+    // nodes changed while counting, applied once it is done; past the cap the count is redone
+    std::vector<NodeId> pending;
+    bool recount = false;
+
+    // result of the last count, kept current by nodesChanged()
+    QRectF bounds;                         // scene rect of the layout
+    std::vector<std::uint8_t> mirror;      // reveal state the counts include
+    std::vector<std::uint32_t> laidOut;    // nodes per pixel
+    std::vector<std::uint32_t> revealedCount;
+    QImage image;
+
+    QRectF viewRect;
+    QPointF dragOffset; // press point to view center, so a drag moves the rect without a jump
+    QThreadPool pool;
+
+    void startCount();
+    void countDone(const std::shared_ptr<Count>& count);
+    void applyChange(NodeId node);
+    void paintPixel(int pixel);
+    QRectF mapRect() const; // where the image is drawn in the widget
+    QPointF toScene(const QPointF& widgetPos) const;
+    QPointF toWidget(const QPointF& scenePos) const;
+    // pixel index of a scene position, the same mapping on the pool and the GUI thread
+    static int pixelOf(const QRectF& bounds, double sceneX, double sceneY);
+};
+
+#endif // MINIMAP_H
@@ -0,0 +1,91 @@
+#include "nodeindex.h"
+#include <algorithm>
+#include <cmath>
+
+// at most this many grid cells per node
+static const size_t CELLS_PER_NODE = 4;
+
+void NodeIndex::clear() {
+    *this = NodeIndex();
+}
+
+void NodeIndex::build(const CallTree& tree, double gap, double w, double h) {
+    clear();
+    hGap = gap;
+    halfW = w;
+    halfH = h;
+    const size_t count = tree.size();
+    if (count == 0) return;
+
+    // ---- occurrences: counting sort of the preorder ids by n ----
+    const int maxK = *std::max_element(tree.n.begin(), tree.n.end());
+    occurrenceOffsets.assign(size_t(maxK) + 2, 0);
+    for (NodeId v = 0; v < count; ++v) ++occurrenceOffsets[tree.n[v] + 1];
+    for (int k = 0; k <= maxK; ++k) occurrenceOffsets[k + 1] += occurrenceOffsets[k];
+    occurrenceIds.resize(count);
+    std::vector<std::uint32_t> fill(occurrenceOffsets.begin(), occurrenceOffsets.end() - 1);
+    for (NodeId v = 0; v < count; ++v) occurrenceIds[fill[tree.n[v]]++] = v;
+
+    // ---- grid: cells at least one node in size, about CELLS_PER_NODE per node at most ----
+    auto [minX, maxX] = std::minmax_element(tree.x.begin(), tree.x.end());
+    auto [minY, maxY] = std::minmax_element(tree.y.begin(), tree.y.end());
+    originX = *minX * hGap - halfW;
+    originY = *minY - halfH;
+    const double spanX = (*maxX - *minX) * hGap + 2 * halfW;
+    const double spanY = *maxY - *minY + 2 * halfH;
+    const size_t maxCells = CELLS_PER_NODE * count + 16;
+    rows = int(std::min<double>(std::ceil(spanY / (2 * halfH)), double(maxCells)));
+    rows = std::max(rows, 1);
+    cols = int(std::min<double>(std::ceil(spanX / (2 * halfW)), double(maxCells / size_t(rows))));
+    cols = std::max(cols, 1);
+    cellW = spanX / cols;
+    cellH = spanY / rows;
+
+    cellOffsets.assign(size_t(rows) * cols + 1, 0);
+    auto cellOf = [&](NodeId v) { return size_t(rowOf(tree.y[v])) * cols + size_t(colOf(tree.x[v] * hGap)); };
+    for (NodeId v = 0; v < count; ++v) ++cellOffsets[cellOf(v) + 1];
+    for (size_t c = 0; c + 1 < cellOffsets.size(); ++c) cellOffsets[c + 1] += cellOffsets[c];
+    cellIds.resize(count);
+    fill.assign(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (NodeId v = 0; v < count; ++v) cellIds[fill[cellOf(v)]++] = v;
+}
+
+int NodeIndex::colOf(double sceneX) const {
+    return std::clamp(int(std::floor((sceneX - originX) / cellW)), 0, cols - 1);
+}
+
+int NodeIndex::rowOf(double sceneY) const {
+    return std::clamp(int(std::floor((sceneY - originY) / cellH)), 0, rows - 1);
+}
+
+// ---------------- queries ----------------
+size_t NodeIndex::occurrences(int k) const {
+    if (k < 0 || size_t(k) + 1 >= occurrenceOffsets.size()) return 0;
+    return occurrenceOffsets[k + 1] - occurrenceOffsets[k];
+}
+
+NodeId NodeIndex::occurrence(int k, size_t i) const {
+    return i < occurrences(k) ? occurrenceIds[occurrenceOffsets[k] + i] : NO_NODE;
+}
+
+NodeId NodeIndex::hitTest(const CallTree& tree, double sceneX, double sceneY) const {
+    if (!isBuilt()) return NO_NODE;
+    // cells are at least a node wide, so centres within reach lie in a 2x2 block at most
+    NodeId best = NO_NODE;
+    double bestDist = 1.0;
+    for (int r = rowOf(sceneY - halfH); r <= rowOf(sceneY + halfH); ++r) {
+        for (int c = colOf(sceneX - halfW); c <= colOf(sceneX + halfW); ++c) {
+            const size_t cell = size_t(r) * cols + size_t(c);
+            for (std::uint32_t i = cellOffsets[cell]; i < cellOffsets[cell + 1]; ++i) {
+                const NodeId v = cellIds[i];
+                const double dx = (sceneX - tree.x[v] * hGap) / halfW, dy = (sceneY - tree.y[v]) / halfH;
+                const double dist = dx * dx + dy * dy;
+                if (dist <= bestDist) {
+                    bestDist = dist;
+                    best = v;
+                }
+            }
+        }
+    }
+    return best;
+}
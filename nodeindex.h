@@ -0,0 +1,37 @@
+#ifndef NODEINDEX_H
+#define NODEINDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "calltree.h"
+
+// Lookup structures over a laid-out CallTree, built in O(N):
+// the calls of every F(k) in preorder, and a packed uniform grid over the scene
+// positions (x * hGap, y) for hit tests. Both are CSR arrays of node ids.
+class NodeIndex {
+public:
+    // nodes are ellipses of half size (halfW, halfH) around their scene position
+    void build(const CallTree& tree, double hGap, double halfW, double halfH);
+    void clear();
+    bool isBuilt() const { return !occurrenceOffsets.empty(); }
+
+    size_t occurrences(int k) const;
+    // the i-th (0-based) call of F(k) in preorder, NO_NODE when there are fewer
+    NodeId occurrence(int k, size_t i) const;
+    // the node whose ellipse contains the scene point, NO_NODE if none
+    NodeId hitTest(const CallTree& tree, double sceneX, double sceneY) const;
+
+private:
+    std::vector<std::uint32_t> occurrenceOffsets; // by k
+    std::vector<NodeId> occurrenceIds;
+    std::vector<std::uint32_t> cellOffsets;       // by row * cols + col
+    std::vector<NodeId> cellIds;
+    double hGap = 1.0, halfW = 0.0, halfH = 0.0;
+    double originX = 0.0, originY = 0.0, cellW = 1.0, cellH = 1.0;
+    int cols = 0, rows = 0;
+
+    int colOf(double sceneX) const;
+    int rowOf(double sceneY) const;
+};
+
+#endif // NODEINDEX_H
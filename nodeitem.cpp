@@ -0,0 +1,86 @@
+#include "nodeitem.h"
+#include "nodelabels.h"
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
+
+// ---------------- NodeItem ----------------
+NodeItem::NodeItem(NodeId node, bool cached, QGraphicsItem* parent)
+    : QGraphicsEllipseItem(parent), nodeId(node), isCached(cached) {
+    // rounded rect centered at (0,0)
+    setRect(-NODE_HALF_W, -NODE_HALF_H, 2 * NODE_HALF_W, 2 * NODE_HALF_H);
+    // modern off-white pen for subtle border
+    setPen(QPen(QColor(240, 244, 249), 1));
+    setFlag(ItemIsSelectable);
+    setFlag(ItemSendsScenePositionChanges);
+
+    applyStyle();
+}
+
+void NodeItem::setNode(const CallTree& tree, NodeId node) {
+    nodeId = node;
+    isCached = tree.cached[node];
+    fibN = tree.n[node];
+    rule = tree.rule;
+    heat = NodeHeat();
+    setPos(tree.x[node] * H_GAP, tree.y[node]);
+    setHighlighted(false);
+}
+
+void NodeItem::setHeat(NodeHeat h) {
+    heat = h;
+    setHighlighted(false);
+}
+
+void NodeItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    QGraphicsEllipseItem::paint(painter, option, widget);
+    // captions are shared static text, skipped entirely while too small to read
+    if (option->levelOfDetailFromTransform(painter->worldTransform()) >= NODE_LABEL_MIN_LOD) {
+        drawNodeLabels(painter, rect(), rule, fibN);
+    }
+}
+
+void NodeItem::applyStyle() {
+    // modern purple -> teal gradient for nodes
+    QLinearGradient grad(rect().topLeft(), rect().bottomRight());
+    grad.setColorAt(0.0, QColor(51, 65, 151));   // deep indigo (#334197)
+    grad.setColorAt(1.0, QColor(20, 184, 166));  // teal-accent (#14B8A6)
+    setBrush(QBrush(grad));
+    setPen(QPen(QColor(240, 244, 249), 1));
+}
+
+void NodeItem::applyHeat() {
+    // fill by the call's own time, outline by the time including its calls: blue (short) to red (long)
+    const double self = (heat.exclusive - 1) / 254.0;
+    const double total = (heat.inclusive - 1) / 254.0;
+    const QColor fill = QColor::fromHsvF(0.66 * (1.0 - self), 0.8, 0.95);
+    QLinearGradient grad(rect().topLeft(), rect().bottomRight());
+    grad.setColorAt(0.0, fill.lighter(115));
+    grad.setColorAt(1.0, fill.darker(130));
+    setBrush(grad);
+    setPen(QPen(QColor::fromHsvF(0.66 * (1.0 - total), 0.6, 1.0), 1.0 + 3.0 * total));
+}
+
+void NodeItem::setHighlighted(bool on) {
+    if (on) {
+        // warm accent gradient for selection (coral -> amber)
+        QLinearGradient grad(rect().topLeft(), rect().bottomRight());
+        grad.setColorAt(0.0, QColor(255, 94, 98));
+        grad.setColorAt(1.0, QColor(255, 159, 67));
+        setBrush(grad);
+    } else if (heat.exclusive != 0) {
+        applyHeat();
+    } else {
+        if (isCached) {
+            // muted slate gradient for cached nodes
+            QLinearGradient grad(rect().topLeft(), rect().bottomRight());
+            grad.setColorAt(0.0, QColor(95, 105, 125));
+            grad.setColorAt(1.0, QColor(65, 75, 95));
+            setBrush(grad);
+            setPen(QPen(QColor(240, 244, 249), 1));
+        } else {
+            applyStyle();
+        }
+    }
+}
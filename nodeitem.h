@@ -0,0 +1,36 @@
+#ifndef NODEITEM_H
+#define NODEITEM_H
+
+#include <QGraphicsEllipseItem>
+#include "calltree.h"
+#include "calltracer.h"
+
+// Tunable geometry
+static const double H_GAP = 110.0; // pixel per logical x unit (horizontal spacing)
+static const double V_GAP = 100.0; // vertical gap in pixels
+static const double NODE_HALF_W = 50.0;
+static const double NODE_HALF_H = 28.0;
+
+class NodeItem : public QGraphicsEllipseItem {
+public:
+    explicit NodeItem(NodeId node, bool cached, QGraphicsItem* parent = nullptr);
+
+    NodeId nodeId;
+    bool isCached;
+    int fibN = 0; // captions come from the shared label cache (nodelabels.h)
+    RecurrenceRule rule = RuleFibonacci;
+    NodeHeat heat;  // measured time of a traced call; zero otherwise
+
+    // (re)bind this item to a node of the tree: labels, position and style
+    void setNode(const CallTree& tree, NodeId node);
+    // color by measured time (after setNode, which clears it); drops the highlight
+    void setHeat(NodeHeat h);
+
+    void setHighlighted(bool on);
+    void applyStyle();
+    void applyHeat();
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+};
+
+#endif // NODEITEM_H
@@ -0,0 +1,61 @@
+#include "nodelabels.h"
+#include "fibvalues.h"
+#include "recurrence.h"
+#include <QFont>
+#include <QPainter>
+#include <QStaticText>
+#include <vector>
+
+namespace {
+
+struct Captions {
+    QStaticText name;  // F(k), or the rule's symbol
+    QStaticText value; // = T(k) as valueLabel() abbreviates it
+    bool ready = false;
+};
+
+const QFont& nameFont() {
+    static const QFont font("Segoe UI", 10, QFont::Bold);
+    return font;
+}
+
+const QFont& valueFont() {
+    static const QFont font("Segoe UI", 8);
+    return font;
+}
+
+void prepareText(QStaticText& text, const QString& s, const QFont& font) {
+    text.setText(s);
+    text.setTextFormat(Qt::PlainText);
+    // keeps the glyph positions, so repaints at the same zoom skip shaping entirely
+    text.setPerformanceHint(QStaticText::AggressiveCaching);
+    text.prepare(QTransform(), font);
+}
+
+const Captions& captionsFor(RecurrenceRule rule, int k) {
+    // a tree only ever uses T(0)..T(n) of one rule, so the vocabulary is tiny
+    static std::vector<Captions> cache[RuleCount];
+    std::vector<Captions> &captions = cache[rule];
+    if (size_t(k) >= captions.size()) captions.resize(size_t(k) + 1);
+    Captions &c = captions[size_t(k)];
+    if (!c.ready) {
+        prepareText(c.name, QString("%1(%2)").arg(QChar(recurrenceSymbol(rule))).arg(k), nameFont());
+        prepareText(c.value, QString("= %1").arg(QString::fromStdString(valueLabel(rule, k))), valueFont());
+        c.ready = true;
+    }
+    return c;
+}
+
+} // namespace
+
+void drawNodeLabels(QPainter* painter, const QRectF& r, RecurrenceRule rule, int k) {
+    const Captions &c = captionsFor(rule, k);
+    // name centred just above the middle, value left-aligned just below it
+    const QSizeF nameSize = c.name.size();
+    painter->setFont(nameFont());
+    painter->setPen(QColor(250, 250, 252));
+    painter->drawStaticText(QPointF(r.center().x() - nameSize.width() / 2, r.center().y() - nameSize.height()), c.name);
+    painter->setFont(valueFont());
+    painter->setPen(QColor(200, 220, 235));
+    painter->drawStaticText(QPointF(r.left() + 4, r.center().y()), c.value);
+}
@@ -0,0 +1,16 @@
+#ifndef NODELABELS_H
+#define NODELABELS_H
+
+#include "calltree.h"
+
+class QPainter;
+class QRectF;
+
+// Node captions "F(k)" and "= value", laid out once per rule and k as QStaticText and shared by
+// every node of every view. GUI thread only: tile renders stay below NODE_LABEL_MIN_LOD.
+static const double NODE_LABEL_MIN_LOD = 0.45; // below this zoom the text is unreadable
+
+// draws the captions of T(k) of a rule inside a node's ellipse rect
+void drawNodeLabels(QPainter* painter, const QRectF& nodeRect, RecurrenceRule rule, int k);
+
+#endif // NODELABELS_H
@@ -0,0 +1,197 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// trace events kept for export; aggregates keep counting past this
+static const size_t MAX_EVENTS = 1 << 20;
+// paint scopes (names starting with "paint") remembered for frame statistics; one per frame,
+// so scopes nested in a frame are named otherwise
+static const size_t FRAME_HISTORY = 120;
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t ts;
+    uint64_t dur;   // scopes
+    int64_t value;  // counters
+    int tid;
+    bool counter;
+};
+
+struct ScopeStats {
+    uint64_t calls = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+};
+
+struct CounterStats {
+    int64_t value = 0;
+    uint64_t firstUs = 0;
+    uint64_t lastUs = 0;
+};
+
+struct NameLess {
+    bool operator()(const char* a, const char* b) const { return std::strcmp(a, b) < 0; }
+};
+
+struct State {
+    std::mutex mutex;
+    std::vector<Event> events;
+    std::map<const char*, ScopeStats, NameLess> scopes;
+    std::map<const char*, CounterStats, NameLess> counters;
+    std::vector<uint64_t> frameUs; // ring of recent paint durations
+    size_t frameNext = 0;
+    size_t dropped = 0;
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+int threadIndex() {
+    static std::atomic<int> nextIndex{0};
+    thread_local int index = nextIndex.fetch_add(1);
+    return index;
+}
+
+const auto clockStart = std::chrono::steady_clock::now();
+
+void appendEvent(State& s, const Event& e) {
+    if (s.events.size() < MAX_EVENTS) s.events.push_back(e);
+    else ++s.dropped;
+}
+
+void appendJsonString(std::string& out, const char* text) {
+    out += '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        out += *c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::on{false};
+
+void Profiler::setEnabled(bool enabled) {
+    on.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::clear() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.events.clear();
+    s.scopes.clear();
+    s.counters.clear();
+    s.frameUs.clear();
+    s.frameNext = 0;
+    s.dropped = 0;
+}
+
+uint64_t Profiler::nowUs() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - clockStart).count());
+}
+
+void Profiler::record(const char* name, uint64_t startUs, uint64_t durUs) {
+    const int tid = threadIndex();
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    appendEvent(s, {name, startUs, durUs, 0, tid, false});
+    ScopeStats& st = s.scopes[name];
+    ++st.calls;
+    st.totalUs += durUs;
+    st.maxUs = std::max(st.maxUs, durUs);
+    if (std::strncmp(name, "paint", 5) == 0) {
+        if (s.frameUs.size() < FRAME_HISTORY) s.frameUs.push_back(durUs);
+        else s.frameUs[s.frameNext] = durUs;
+        s.frameNext = (s.frameNext + 1) % FRAME_HISTORY;
+    }
+}
+
+void Profiler::count(const char* name, int64_t delta) {
+    const uint64_t ts = nowUs();
+    const int tid = threadIndex();
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    CounterStats& c = s.counters[name];
+    if (c.firstUs == 0) c.firstUs = ts;
+    c.lastUs = ts;
+    c.value += delta;
+    appendEvent(s, {name, ts, 0, c.value, tid, true});
+}
+
+// ---------------- reports ----------------
+std::string Profiler::summary() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::string out;
+    char line[160];
+    if (s.scopes.empty() && s.counters.empty()) return "No samples yet.\n";
+
+    std::snprintf(line, sizeof(line), "%-22s %6s %10s %9s %9s\n", "phase", "calls", "total ms", "avg ms", "max ms");
+    out += line;
+    for (const auto &entry : s.scopes) {
+        const ScopeStats &st = entry.second;
+        std::snprintf(line, sizeof(line), "%-22s %6llu %10.2f %9.3f %9.3f\n", entry.first,
+                      (unsigned long long)st.calls, st.totalUs / 1e3, st.totalUs / 1e3 / st.calls, st.maxUs / 1e3);
+        out += line;
+    }
+    for (const auto &entry : s.counters) {
+        const CounterStats &c = entry.second;
+        const double spanS = (c.lastUs - c.firstUs) / 1e6;
+        std::snprintf(line, sizeof(line), "%s: %lld", entry.first, (long long)c.value);
+        out += line;
+        if (spanS > 0) {
+            std::snprintf(line, sizeof(line), " (%.0f/s)", c.value / spanS);
+            out += line;
+        }
+        out += "\n";
+    }
+    if (!s.frameUs.empty()) {
+        std::vector<uint64_t> frames = s.frameUs;
+        std::sort(frames.begin(), frames.end());
+        uint64_t sum = 0;
+        for (uint64_t f : frames) sum += f;
+        std::snprintf(line, sizeof(line), "Frames (last %zu): avg %.2f ms, p95 %.2f ms, max %.2f ms\n", frames.size(),
+                      sum / 1e3 / frames.size(), frames[frames.size() * 95 / 100] / 1e3, frames.back() / 1e3);
+        out += line;
+    }
+    if (s.dropped > 0) {
+        std::snprintf(line, sizeof(line), "(%zu trace events over the limit were not kept)\n", s.dropped);
+        out += line;
+    }
+    return out;
+}
+
+std::string Profiler::chromeTrace() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out.reserve(out.size() + s.events.size() * 96);
+    char line[160];
+    for (size_t i = 0; i < s.events.size(); ++i) {
+        const Event &e = s.events[i];
+        out += "{\"name\":";
+        appendJsonString(out, e.name);
+        if (e.counter) {
+            std::snprintf(line, sizeof(line), ",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%lld}}",
+                          (unsigned long long)e.ts, e.tid, (long long)e.value);
+        } else {
+            std::snprintf(line, sizeof(line), ",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%d}",
+                          (unsigned long long)e.ts, (unsigned long long)e.dur, e.tid);
+        }
+        out += line;
+        out += i + 1 < s.events.size() ? ",\n" : "\n";
+    }
+    out += "]}\n";
+    return out;
+}
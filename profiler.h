@@ -0,0 +1,52 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Phase profiler: scoped timers and counters, kept as Chrome trace events.
+// Off by default; a scope or counter hit while it is off costs one relaxed atomic load.
+// Names must be string literals (they are stored by pointer). Safe to use from any thread.
+class Profiler {
+public:
+    static bool enabled() { return on.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static void clear();
+
+    static uint64_t nowUs(); // steady clock, microseconds
+    static void record(const char* name, uint64_t startUs, uint64_t durUs);
+    // adds delta to a running counter; the trace shows its value over time
+    static void count(const char* name, int64_t delta);
+
+    // calls, total/avg/max ms per scope, counter rates and paint frame times
+    static std::string summary();
+    // trace-event JSON for chrome://tracing or ui.perfetto.dev; callers write it to a file
+    static std::string chromeTrace();
+
+private:
+    static std::atomic<bool> on;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* scopeName)
+        : name(Profiler::enabled() ? scopeName : nullptr), start(name ? Profiler::nowUs() : 0) {}
+    ~ProfileScope() {
+        if (name) Profiler::record(name, start, Profiler::nowUs() - start);
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_COUNT(name, delta) \
+    do { if (Profiler::enabled()) Profiler::count(name, delta); } while (0)
+
+#endif // PROFILER_H
@@ -0,0 +1,257 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "calltree.h"
+
+// Recurrences T(k) = T(k - o1) + ... + T(k - oA) whose call trees the builders produce.
+// A rule lists its offsets (in call order) and the values of its base cases T(0) .. T(B-1),
+// where B is the largest offset: calls below B are leaves, every other call has A children.
+// Trees of every rule are built, laid out, labelled, stored, saved and revealed alike; values
+// past 64 bits, the implicit view, tracing, the memo DAG and subtree composition are F(k) only.
+struct FibonacciRule {
+    static constexpr RecurrenceRule ID = RuleFibonacci;
+    static constexpr std::array<int, 2> OFFSETS = {1, 2};
+    static constexpr std::array<std::uint64_t, 2> BASE = {0, 1};
+    static constexpr const char* NAME = "Fibonacci";
+    static constexpr char SYMBOL = 'F';
+};
+
+struct TribonacciRule {
+    static constexpr RecurrenceRule ID = RuleTribonacci;
+    static constexpr std::array<int, 3> OFFSETS = {1, 2, 3};
+    static constexpr std::array<std::uint64_t, 3> BASE = {0, 0, 1};
+    static constexpr const char* NAME = "Tribonacci";
+    static constexpr char SYMBOL = 'T';
+};
+
+struct PadovanRule {
+    static constexpr RecurrenceRule ID = RulePadovan;
+    static constexpr std::array<int, 2> OFFSETS = {2, 3};
+    static constexpr std::array<std::uint64_t, 3> BASE = {1, 1, 1};
+    static constexpr const char* NAME = "Padovan";
+    static constexpr char SYMBOL = 'P';
+};
+
+// sum of row k of Pascal's triangle, 2^k, called as B(k-1) + B(k-1): a complete binary tree
+struct BinomialRowRule {
+    static constexpr RecurrenceRule ID = RuleBinomialRow;
+    static constexpr std::array<int, 2> OFFSETS = {1, 1};
+    static constexpr std::array<std::uint64_t, 1> BASE = {1};
+    static constexpr const char* NAME = "Binomial row sums";
+    static constexpr char SYMBOL = 'B';
+};
+
+// Per-k tables of a rule, filled at compile time up to the last k whose call tree
+// (and value) still counts in 64 bits
+struct RecurrenceTables {
+    static constexpr int SIZE = 128;
+    int maxN = -1;
+    std::uint64_t value[SIZE] = {};
+    std::uint64_t size[SIZE] = {};     // nodes of the naive call tree of T(k)
+    std::uint64_t leaves[SIZE] = {};
+    double relX[SIZE] = {};            // x of T(k) relative to its first leaf slot
+    std::uint64_t memoSize[SIZE] = {}; // nodes of the memoized call tree of T(k)
+};
+
+template <class Rule>
+constexpr RecurrenceTables makeRecurrenceTables() {
+    constexpr int arity = int(Rule::OFFSETS.size());
+    constexpr int base = int(Rule::BASE.size());
+    RecurrenceTables t;
+    for (int k = 0; k < RecurrenceTables::SIZE; ++k) {
+        if (k < base) {
+            t.value[k] = Rule::BASE[k];
+            t.size[k] = t.leaves[k] = 1;
+        } else {
+            std::uint64_t value = 0, size = 1, leaves = 0;
+            bool fits = true;
+            for (int i = 0; i < arity; ++i) {
+                const int c = k - Rule::OFFSETS[i];
+                fits = fits && value <= UINT64_MAX - t.value[c] && size <= UINT64_MAX - t.size[c];
+                value += t.value[c];
+                size += t.size[c];
+                leaves += t.leaves[c];
+            }
+            if (!fits) break;
+            t.value[k] = value;
+            t.size[k] = size;
+            t.leaves[k] = leaves;
+            // centered over the outer children, as CallTree::assignPositions places it
+            const int last = k - Rule::OFFSETS[arity - 1];
+            t.relX[k] = (t.relX[k - Rule::OFFSETS[0]] + (double(leaves - t.leaves[last]) + t.relX[last])) / 2.0;
+        }
+        // every T(j), j >= B, reached from T(k) is expanded once, with A children
+        bool reached[RecurrenceTables::SIZE] = {};
+        reached[k] = true;
+        std::uint64_t expanded = 0;
+        for (int j = k; j >= base; --j) {
+            if (!reached[j]) continue;
+            ++expanded;
+            for (int i = 0; i < arity; ++i) reached[j - Rule::OFFSETS[i]] = true;
+        }
+        t.memoSize[k] = 1 + arity * expanded;
+        t.maxN = k;
+    }
+    return t;
+}
+
+// Call trees of one rule, built into a CallTree arena in preorder like the Fibonacci builders,
+// so layout, rendering, files and the reveal timeline need nothing rule specific. Node counts,
+// leaf counts and x offsets of the naive tree are table lookups up to MAX_N.
+template <class Rule>
+class Recurrence {
+public:
+    static constexpr int ARITY = int(Rule::OFFSETS.size());
+    static constexpr int BASE = int(Rule::BASE.size());
+    static constexpr RecurrenceTables TABLES = makeRecurrenceTables<Rule>();
+    static constexpr int MAX_N = TABLES.maxN;
+    static constexpr const char* NAME = Rule::NAME;
+    static constexpr char SYMBOL = Rule::SYMBOL;
+
+    static constexpr bool isLeaf(int k) { return k < BASE; }
+    static constexpr std::uint64_t value(int k) { return TABLES.value[k]; }
+    static constexpr std::uint64_t subtreeSize(int k) { return TABLES.size[k]; }
+    static constexpr std::uint64_t subtreeLeaves(int k) { return TABLES.leaves[k]; }
+    static constexpr double relativeX(int k) { return TABLES.relX[k]; }
+
+    // SIZE_MAX past MAX_N, which no budget admits
+    static size_t naiveNodeCount(int n) {
+        return n <= MAX_N ? size_t(TABLES.size[n]) : SIZE_MAX;
+    }
+    static size_t memoNodeCount(int n) {
+        if (n <= MAX_N) return size_t(TABLES.memoSize[n]);
+        std::vector<std::uint8_t> reached(size_t(n) + 1, 0);
+        reached[size_t(n)] = 1;
+        size_t expanded = 0;
+        for (int j = n; j >= BASE; --j) {
+            if (!reached[size_t(j)]) continue;
+            ++expanded;
+            for (int o : Rule::OFFSETS) reached[size_t(j - o)] = 1;
+        }
+        return 1 + size_t(ARITY) * expanded;
+    }
+
+    // Naive tree of T(n) laid out as it is written: every subtree's preorder range and leaf
+    // slots follow from the tables. Rows are vertGap apart. NO_NODE past MAX_N or when cancelled.
+    static NodeId buildNaive(CallTree& tree, int n, double vertGap, BuildControl* control = nullptr) {
+        struct Call { int k; NodeId id; NodeId parent; int depth; std::uint64_t leafStart; };
+        if (n < 0 || n > MAX_N) return NO_NODE;
+        tree.allocate(naiveNodeCount(n));
+        tree.rule = Rule::ID;
+        std::vector<Call> stack;
+        stack.reserve(size_t(n) * (ARITY - 1) + 2);
+        stack.push_back({n, 0, NO_NODE, 0, 0});
+        size_t written = 0;
+        while (!stack.empty()) {
+            const Call call = stack.back();
+            stack.pop_back();
+            if (control && ++written == BuildControl::INTERVAL) {
+                control->nodesDone.fetch_add(written, std::memory_order_relaxed);
+                written = 0;
+                if (control->cancel.load(std::memory_order_relaxed)) return NO_NODE;
+            }
+            const NodeId id = call.id;
+            tree.n[id] = call.k;
+            tree.parent[id] = call.parent;
+            tree.depth[id] = call.depth;
+            tree.x[id] = double(call.leafStart) + TABLES.relX[call.k];
+            tree.y[id] = call.depth * vertGap;
+            if (isLeaf(call.k)) continue;
+            // children in call order; each starts right after the previous one's subtree
+            Call children[ARITY];
+            NodeId child = id + 1;
+            std::uint64_t slot = call.leafStart;
+            tree.firstChild[id] = child;
+            for (int i = 0; i < ARITY; ++i) {
+                const int k = call.k - Rule::OFFSETS[i];
+                children[i] = {k, child, id, call.depth + 1, slot};
+                const NodeId next = NodeId(child + TABLES.size[k]);
+                if (i + 1 < ARITY) tree.nextSibling[child] = next;
+                child = next;
+                slot += TABLES.leaves[k];
+            }
+            for (int i = ARITY; i-- > 0;) stack.push_back(children[i]);
+        }
+        if (control) control->nodesDone.fetch_add(written, std::memory_order_relaxed);
+        return 0;
+    }
+
+    // Memoized recursion of T(n): a call of a k seen before (base cases included) is a
+    // cached leaf. Not laid out: see CallTree::assignPositions.
+    static NodeId buildMemo(CallTree& tree, int n, BuildControl* control = nullptr) {
+        // linear in n, so only checked once
+        if (control && control->cancel.load(std::memory_order_relaxed)) return NO_NODE;
+        struct Call { int k; NodeId parent; int depth; };
+        tree.allocate(memoNodeCount(n));
+        tree.rule = Rule::ID;
+        std::vector<std::uint8_t> seen(size_t(n) + 1, 0);
+        std::vector<NodeId> lastAtDepth; // previous node of each row, a sibling when parents match
+        std::vector<Call> stack;
+        stack.push_back({n, NO_NODE, 0});
+        NodeId id = 0;
+        while (!stack.empty()) {
+            const Call call = stack.back();
+            stack.pop_back();
+            tree.n[id] = call.k;
+            tree.parent[id] = call.parent;
+            tree.depth[id] = call.depth;
+            if (size_t(call.depth) == lastAtDepth.size()) lastAtDepth.push_back(NO_NODE);
+            NodeId &previous = lastAtDepth[size_t(call.depth)];
+            if (call.parent != NO_NODE) {
+                if (previous != NO_NODE && tree.parent[previous] == call.parent) tree.nextSibling[previous] = id;
+                else tree.firstChild[call.parent] = id;
+            }
+            previous = id;
+            if (seen[size_t(call.k)]) {
+                tree.cached[id] = 1;
+            } else {
+                seen[size_t(call.k)] = 1;
+                if (!isLeaf(call.k)) {
+                    for (int i = ARITY; i-- > 0;) stack.push_back({call.k - Rule::OFFSETS[i], id, call.depth + 1});
+                }
+            }
+            ++id;
+        }
+        if (control) control->nodesDone.store(tree.size(), std::memory_order_relaxed);
+        return 0;
+    }
+};
+
+using FibonacciRecurrence = Recurrence<FibonacciRule>;
+
+// f(Recurrence<Rule>()) for a rule chosen at run time, e.g. from the UI or a tree file
+template <class F>
+decltype(auto) visitRecurrence(RecurrenceRule rule, F&& f) {
+    switch (rule) {
+    case RuleTribonacci: return f(Recurrence<TribonacciRule>());
+    case RulePadovan: return f(Recurrence<PadovanRule>());
+    case RuleBinomialRow: return f(Recurrence<BinomialRowRule>());
+    default: return f(Recurrence<FibonacciRule>());
+    }
+}
+
+inline const char* recurrenceName(RecurrenceRule rule) {
+    return visitRecurrence(rule, [](auto r) { return decltype(r)::NAME; });
+}
+inline char recurrenceSymbol(RecurrenceRule rule) {
+    return visitRecurrence(rule, [](auto r) { return decltype(r)::SYMBOL; });
+}
+// largest n whose naive tree and value count in 64 bits
+inline int recurrenceMaxN(RecurrenceRule rule) {
+    return visitRecurrence(rule, [](auto r) { return decltype(r)::MAX_N; });
+}
+
+static_assert(FibonacciRecurrence::MAX_N == 91, "2*F(92)-1 is the last Fibonacci tree size that fits 64 bits");
+static_assert(FibonacciRecurrence::value(90) == 2880067194370816120ull, "F(90)");
+static_assert(FibonacciRecurrence::subtreeSize(10) == 177 && FibonacciRecurrence::subtreeLeaves(10) == 89,
+              "the subtree of F(k) has 2*F(k+1)-1 nodes and F(k+1) leaves");
+static_assert(FibonacciRecurrence::TABLES.memoSize[10] == 19, "the memoized F(n) tree has 2n-1 nodes");
+static_assert(Recurrence<TribonacciRule>::value(10) == 81, "T(10)");
+static_assert(Recurrence<PadovanRule>::value(10) == 12, "P(10)");
+static_assert(Recurrence<BinomialRowRule>::value(10) == 1024 && Recurrence<BinomialRowRule>::subtreeSize(10) == 2047,
+              "2^k, a complete binary tree of depth k");
+
+#endif // RECURRENCE_H
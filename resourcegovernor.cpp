@@ -0,0 +1,229 @@
+#include "resourcegovernor.h"
+#include "allocstats.h"
+#include "calltree.h"
+#include "nodeitem.h"
+#include "profiler.h"
+#include "revealtimeline.h"
+#include "tilecache.h"
+#include "treepainteritem.h"
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QImage>
+#include <QPainter>
+#include <algorithm>
+#include <vector>
+
+// default budget: this share of the installed memory, or FALLBACK_BUDGET when unknown
+static const double BUDGET_SHARE = 0.5;
+static const double FALLBACK_BUDGET = 1024.0 * 1024 * 1024;
+// share of the budget stored subtrees may keep between draws; the rest is left for the tree shown
+static const double STORE_SHARE = 0.25;
+// longest acceptable wait for build plus scene items, and paint of one full frame
+static const double MAX_WAIT_MS = 15000.0;
+static const double MAX_PAINT_MS = 500.0;
+// calibration tree (3193 nodes: below the batched painter's tile threshold) and items timed
+static const int CALIBRATION_N = 16;
+static const NodeId CALIBRATION_ITEMS = 512;
+static const int CALIBRATION_IMAGE_PX = 512;
+// per-node bookkeeping beside the arena: timeline events (two per node in call/return
+// order), its visibility bit and the reveal flag; checkpoints have their own byte cap
+static const double REVEAL_BYTES = 2 * sizeof(RevealTimeline::Event) + 1.125;
+// scene items mode: item pointer, edge pointer, edge pair and incidence index entries
+static const double ITEM_INDEX_BYTES = 2 * sizeof(void*) + 2 * sizeof(NodeId) + 3 * sizeof(uint32_t);
+// DepthRows entry kept by the virtualized scene and the batched painter
+static const double ROW_INDEX_BYTES = sizeof(NodeId);
+// per-node size of a node item with its edge line, private data and scene index entries,
+// used when the heap counters are not built in (see allocstats.h)
+static const double UNCOUNTED_ITEM_BYTES = 1200.0;
+// items the virtualized pool holds for a full viewport
+static const double VIRTUAL_POOL_ITEMS = 4000.0;
+// the batched painter tiles trees from this size on; the cache keeps at most 512 tiles
+static const uint64_t TILED_NODES = 4096;
+static const double TILE_CACHE_BYTES = 512.0 * TileCache::TILE_PX * TileCache::TILE_PX * 4;
+
+ResourceGovernor::ResourceGovernor() {
+    const size_t installed = AllocStats::physicalMemoryBytes();
+    budgetBytes = installed > 0 ? installed * BUDGET_SHARE : FALLBACK_BUDGET;
+}
+
+double ResourceGovernor::storeBudget() const {
+    return budgetBytes * STORE_SHARE;
+}
+
+// ---------------- calibration ----------------
+void ResourceGovernor::calibrate() {
+    PROFILE_SCOPE("calibrate");
+    QElapsedTimer timer;
+
+    // arena: built the way TreeBuilder builds naive trees
+    AllocStats before = AllocStats::now();
+    timer.start();
+    CallTree tree;
+    tree.buildNaiveFibParallel(CALIBRATION_N, 1, V_GAP);
+    const double nodes = double(tree.size());
+    perNode.buildNs = timer.nsecsElapsed() / nodes;
+    const double arenaBytes = AllocStats::counting() ? (AllocStats::now() - before).bytes / nodes
+                                                    : double(CallTree::NODE_BYTES);
+    perNode.arenaBytes = arenaBytes + REVEAL_BYTES;
+
+    // scene items: created as populateSceneItems() does, then painted fitted to an image
+    std::vector<std::uint8_t> shown(tree.size(), 1);
+    QImage image(CALIBRATION_IMAGE_PX, CALIBRATION_IMAGE_PX, QImage::Format_ARGB32_Premultiplied);
+    // the first paint fills font and sprite caches, so the second one is timed
+    auto timePaint = [&image](QGraphicsScene& scene) {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        scene.render(&painter);
+        QElapsedTimer paintTimer;
+        paintTimer.start();
+        scene.render(&painter);
+        return double(paintTimer.nsecsElapsed());
+    };
+    {
+        QGraphicsScene scene;
+        before = AllocStats::now();
+        timer.restart();
+        const NodeId items = std::min<NodeId>(CALIBRATION_ITEMS, NodeId(tree.size()));
+        std::vector<NodeItem*> created(items, nullptr);
+        for (NodeId v = 0; v < items; ++v) {
+            created[v] = new NodeItem(v, tree.cached[v]);
+            created[v]->setNode(tree, v);
+            scene.addItem(created[v]);
+            if (tree.parent[v] != NO_NODE) scene.addLine(QLineF(created[tree.parent[v]]->pos(), created[v]->pos()));
+        }
+        perNode.itemNs = timer.nsecsElapsed() / double(items);
+        perNode.itemBytes = AllocStats::counting() ? (AllocStats::now() - before).bytes / double(items) : UNCOUNTED_ITEM_BYTES;
+        perNode.itemPaintNs = timePaint(scene) / double(items);
+    }
+    {
+        QGraphicsScene scene;
+        scene.addItem(new TreePainterItem(&tree, &shown));
+        perNode.batchedPaintNs = timePaint(scene) / nodes;
+    }
+    calibrated = true;
+}
+
+// ---------------- cost model ----------------
+uint64_t ResourceGovernor::nodeCount(RecurrenceRule rule, int n, bool naive) {
+    return naive ? CallTree::naiveNodeCount(rule, n) : CallTree::memoNodeCount(rule, n);
+}
+
+CostEstimate ResourceGovernor::estimate(uint64_t nodes, Strategy strategy, bool build) const {
+    CostEstimate cost;
+    cost.nodes = nodes;
+    cost.edges = nodes > 0 ? nodes - 1 : 0;
+    // the implicit view derives every node from its index and F(n) only keeps one number
+    if (strategy == StrategyImplicit || strategy == StrategyValueOnly) return cost;
+
+    const double count = double(nodes);
+    cost.arenaBytes = count * perNode.arenaBytes;
+    cost.buildMs = build ? count * perNode.buildNs / 1e6 : 0.0;
+    if (strategy == StrategyItems) {
+        cost.sceneBytes = count * (perNode.itemBytes + ITEM_INDEX_BYTES);
+        cost.sceneMs = count * perNode.itemNs / 1e6;
+        cost.paintMs = count * perNode.itemPaintNs / 1e6;
+    } else if (strategy == StrategyVirtualized) {
+        // items only for what one viewport shows
+        const double pooled = std::min(count, VIRTUAL_POOL_ITEMS);
+        cost.sceneBytes = count * ROW_INDEX_BYTES + pooled * perNode.itemBytes;
+        cost.sceneMs = pooled * perNode.itemNs / 1e6;
+        cost.paintMs = pooled * perNode.itemPaintNs / 1e6;
+    } else {
+        // rows index and reveal snapshot, plus the tile cache once it is used
+        cost.sceneBytes = count * (ROW_INDEX_BYTES + 1) + (nodes >= TILED_NODES ? TILE_CACHE_BYTES : 0.0);
+        cost.paintMs = count * perNode.batchedPaintNs / 1e6;
+    }
+    return cost;
+}
+
+bool ResourceGovernor::fits(Strategy strategy, const CostEstimate& cost, QString* why) const {
+    // arena node ids are 32-bit with NO_NODE reserved (naive F(46) is past that); the implicit
+    // view and F(n) alone build no arena
+    if (strategy < StrategyImplicit && cost.nodes >= NO_NODE) {
+        *why = QString("has more nodes than the %1 a tree can index").arg(qulonglong(NO_NODE) - 1);
+        return false;
+    }
+    if (cost.bytes() > availableBytes()) {
+        *why = QString("needs about %1, over the %2 left of the budget").arg(bytesText(cost.bytes()), bytesText(availableBytes()));
+        return false;
+    }
+    if (cost.buildMs + cost.sceneMs > MAX_WAIT_MS) {
+        *why = QString("would take about %1 s to build").arg((cost.buildMs + cost.sceneMs) / 1000.0, 0, 'f', 1);
+        return false;
+    }
+    if (cost.paintMs > MAX_PAINT_MS) {
+        *why = QString("would take about %1 ms to paint").arg(cost.paintMs, 0, 'f', 0);
+        return false;
+    }
+    return true;
+}
+
+// ---------------- planning ----------------
+ResourceGovernor::Plan ResourceGovernor::choose(uint64_t nodes, bool build, bool implicitOk,
+                                                Strategy requested, Strategy last) const {
+    Plan plan;
+    QString firstRefusal;
+    for (int s = requested; s <= last; ++s) {
+        const Strategy strategy = Strategy(s);
+        if (strategy == StrategyImplicit && !implicitOk) continue;
+        plan.strategy = strategy;
+        plan.cost = estimate(nodes, strategy, build);
+        // the last strategy is used whatever it costs
+        QString why;
+        if (strategy == last || fits(strategy, plan.cost, &why)) break;
+        if (firstRefusal.isEmpty()) firstRefusal = QString("%1 %2").arg(strategyName(strategy), why);
+    }
+    if (plan.strategy != requested) {
+        plan.reason = QString("%1 for %2 nodes; showing %3 instead")
+                          .arg(firstRefusal).arg(qulonglong(nodes)).arg(strategyName(plan.strategy));
+    }
+    return plan;
+}
+
+ResourceGovernor::Plan ResourceGovernor::plan(RecurrenceRule rule, int n, bool naive, Strategy requested) const {
+    // the implicit engine only knows the naive Fibonacci tree; memo trees are small enough to draw directly
+    const bool implicitOk = naive && rule == RuleFibonacci;
+    if (requested == StrategyImplicit && !implicitOk) requested = StrategyBatched;
+    return choose(nodeCount(rule, n, naive), true, implicitOk, requested, StrategyValueOnly);
+}
+
+ResourceGovernor::Plan ResourceGovernor::planLoaded(uint64_t nodes, Strategy requested) const {
+    if (requested >= StrategyImplicit) requested = StrategyBatched;
+    return choose(nodes, false, false, requested, StrategyBatched);
+}
+
+// ---------------- text ----------------
+QString ResourceGovernor::strategyName(Strategy strategy) {
+    switch (strategy) {
+    case StrategyItems: return "Scene items";
+    case StrategyVirtualized: return "Virtualized";
+    case StrategyBatched: return "Batched painter";
+    case StrategyImplicit: return "Implicit";
+    default: return "F(n) only";
+    }
+}
+
+QString ResourceGovernor::bytesText(double bytes) {
+    if (bytes >= 1024.0 * 1024 * 1024) return QString("%1 GB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 1);
+    if (bytes >= 1024.0 * 1024) return QString("%1 MB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+    return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+}
+
+QString ResourceGovernor::describe(const CostEstimate& cost) const {
+    QString s;
+    s += QString("Predicted: %1 nodes, %2 edges\n").arg(qulonglong(cost.nodes)).arg(qulonglong(cost.edges));
+    s += QString("  memory %1 of %2 (arena %3, scene %4; stored subtrees %5)\n")
+             .arg(bytesText(cost.bytes()), bytesText(availableBytes()), bytesText(cost.arenaBytes), bytesText(cost.sceneBytes),
+                  bytesText(reservedBytes));
+    s += QString("  build %1 ms, scene items %2 ms, full paint %3 ms%4\n")
+             .arg(cost.buildMs, 0, 'f', 1).arg(cost.sceneMs, 0, 'f', 1).arg(cost.paintMs, 0, 'f', 1)
+             .arg(calibrated ? "" : " (not calibrated)");
+    return s;
+}
+
+QString ResourceGovernor::calibrationText() const {
+    return QString("Per node: build %1 ns, arena %2 B; scene item %3 us, %4 B, paint %5 us; batched paint %6 ns")
+        .arg(perNode.buildNs, 0, 'f', 0).arg(perNode.arenaBytes, 0, 'f', 0)
+        .arg(perNode.itemNs / 1000.0, 0, 'f', 1).arg(perNode.itemBytes, 0, 'f', 0)
+        .arg(perNode.itemPaintNs / 1000.0, 0, 'f', 1).arg(perNode.batchedPaintNs, 0, 'f', 0);
+}
@@ -0,0 +1,89 @@
+#ifndef RESOURCEGOVERNOR_H
+#define RESOURCEGOVERNOR_H
+
+#include <QString>
+#include <algorithm>
+#include <cstdint>
+#include "calltree.h"
+
+// Ways of putting F(n) on screen, from the most to the least costly scene.
+// The first four are the RenderMode values (the order of comboRenderer).
+enum Strategy {
+    StrategyItems = 0,
+    StrategyVirtualized,
+    StrategyBatched,
+    StrategyImplicit,  // naive Fibonacci trees only
+    StrategyValueOnly,
+    StrategyCount
+};
+
+// Predicted cost of showing one tree one way, computed before anything is allocated
+struct CostEstimate {
+    uint64_t nodes = 0;
+    uint64_t edges = 0;
+    double arenaBytes = 0; // CallTree columns, visit order and reveal state
+    double sceneBytes = 0; // items, pools, snapshots and tiles
+    double buildMs = 0;    // build and layout on the worker
+    double sceneMs = 0;    // creating scene items on the GUI thread
+    double paintMs = 0;    // painting the whole tree fitted to the view
+
+    double bytes() const { return arenaBytes + sceneBytes; }
+};
+
+// Cost model for the tree views: closed-form node counts times per-node costs measured
+// by calibrate(), and the choice of a strategy that fits the memory and time budgets.
+class ResourceGovernor {
+public:
+    struct Plan {
+        Strategy strategy = StrategyValueOnly;
+        CostEstimate cost;
+        QString reason; // why the requested strategy was not used; empty when it was
+    };
+
+    ResourceGovernor();
+
+    // times and measures a small tree, its scene items and its batched paint (tens of ms)
+    void calibrate();
+    bool isCalibrated() const { return calibrated; }
+
+    double memoryBudget() const { return budgetBytes; }
+    void setMemoryBudget(double bytes) { budgetBytes = bytes; }
+    // memory already held outside the planned tree (the builder's subtree store), taken off the budget
+    void setReservedBytes(double bytes) { reservedBytes = bytes; }
+    double availableBytes() const { return std::max(0.0, budgetBytes - reservedBytes); }
+    // what the builder's subtree store may keep, a share of the budget
+    double storeBudget() const;
+
+    static uint64_t nodeCount(RecurrenceRule rule, int n, bool naive);
+    static QString strategyName(Strategy strategy);
+    static QString bytesText(double bytes);
+
+    CostEstimate estimate(uint64_t nodes, Strategy strategy, bool build = true) const;
+    // the requested strategy when it fits, otherwise the next cheaper one that does
+    Plan plan(RecurrenceRule rule, int n, bool naive, Strategy requested) const;
+    // trees opened from a file are already laid out and cannot fall back to the implicit view
+    Plan planLoaded(uint64_t nodes, Strategy requested) const;
+    QString describe(const CostEstimate& cost) const;
+    // the measured per-node costs, one line
+    QString calibrationText() const;
+
+private:
+    // measured by calibrate(); until then rough figures for a desktop machine
+    struct PerNode {
+        double buildNs = 40.0;
+        double arenaBytes = 80.0;
+        double itemNs = 4000.0;
+        double itemBytes = 1200.0;
+        double itemPaintNs = 3000.0;
+        double batchedPaintNs = 150.0;
+    };
+    PerNode perNode;
+    double budgetBytes;
+    double reservedBytes = 0;
+    bool calibrated = false;
+
+    bool fits(Strategy strategy, const CostEstimate& cost, QString* why) const;
+    Plan choose(uint64_t nodes, bool build, bool implicitOk, Strategy requested, Strategy last) const;
+};
+
+#endif // RESOURCEGOVERNOR_H
@@ -0,0 +1,45 @@
+#include "revealanimator.h"
+#include "nodeitem.h"
+
+static const int POP_MS = 220;           // pop-in duration
+static const double POP_START_SCALE = 0.25;
+
+RevealAnimator::RevealAnimator(QObject* parent) : QAbstractAnimation(parent) {}
+
+void RevealAnimator::ensureRunning() {
+    if (state() != Running) start();
+}
+
+void RevealAnimator::popIn(NodeItem* item) {
+    ensureRunning();
+    item->setScale(POP_START_SCALE);
+    pops.push_back({item, currentTime()});
+}
+
+void RevealAnimator::setFrameWork(bool enabled) {
+    frameWork = enabled;
+    if (frameWork) ensureRunning();
+}
+
+void RevealAnimator::clear() {
+    pops.clear();
+    frameWork = false;
+    stop();
+}
+
+void RevealAnimator::updateCurrentTime(int currentTime) {
+    // every in-flight pop-in advances from the same clock value; finished ones are swapped out
+    for (size_t i = 0; i < pops.size();) {
+        double t = double(currentTime - pops[i].start) / POP_MS;
+        if (t >= 1.0) {
+            pops[i].item->setScale(1.0);
+            pops[i] = pops.back();
+            pops.pop_back();
+        } else {
+            pops[i].item->setScale(POP_START_SCALE + (1.0 - POP_START_SCALE) * t);
+            ++i;
+        }
+    }
+    if (frameWork) emit frame();
+    if (pops.empty() && !frameWork) stop();
+}
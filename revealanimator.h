@@ -0,0 +1,43 @@
+#ifndef REVEALANIMATOR_H
+#define REVEALANIMATOR_H
+
+#include <QAbstractAnimation>
+#include <vector>
+
+class NodeItem;
+
+// One clock for every node pop-in and for the per-frame reveal work of Skip.
+// Runs on Qt's animation timer, which ticks once per display frame, and only while
+// a pop-in is in flight or frame work is requested.
+class RevealAnimator : public QAbstractAnimation {
+    Q_OBJECT
+
+public:
+    explicit RevealAnimator(QObject* parent = nullptr);
+
+    int duration() const override { return -1; } // runs until stopped
+
+    // scale item from small to full size over the next POP_MS
+    void popIn(NodeItem* item);
+    // emit frame() on every tick while enabled
+    void setFrameWork(bool enabled);
+    // forget every item, e.g. before the scene deletes them
+    void clear();
+
+    int inFlight() const { return int(pops.size()); }
+
+signals:
+    void frame();
+
+protected:
+    void updateCurrentTime(int currentTime) override;
+
+private:
+    struct Pop { NodeItem* item; int start; };
+    std::vector<Pop> pops;
+    bool frameWork = false;
+
+    void ensureRunning();
+};
+
+#endif // REVEALANIMATOR_H
@@ -0,0 +1,136 @@
+#include "revealtimeline.h"
+#include "profiler.h"
+#include <algorithm>
+
+// checkpoints never take more than this, however large the tree
+static const size_t CHECKPOINT_BYTES = 64 * 1024 * 1024;
+// below this many events between checkpoints a bitset copy costs more than the replay
+static const size_t MIN_INTERVAL = 256;
+
+static uint64_t bitOf(NodeId node) { return uint64_t(1) << (node & 63); }
+
+// ---------------- building ----------------
+void RevealTimeline::build(const CallTree& tree, RevealSchedule schedule) {
+    PROFILE_SCOPE("build timeline");
+    clear();
+    kind = schedule;
+    if (tree.empty()) return;
+
+    events.reserve(schedule == ScheduleCallReturn ? 2 * tree.size() : tree.size());
+    if (schedule == ScheduleBreadthFirst) {
+        // the event list is the queue
+        events.push_back({0, true});
+        for (size_t head = 0; head < events.size(); ++head) {
+            for (NodeId c = tree.firstChild[events[head].node]; c != NO_NODE; c = tree.nextSibling[c]) {
+                events.push_back({c, true});
+            }
+        }
+    } else {
+        // the recursion itself, with its call stack made explicit; preorder keeps the calls
+        // and post-order the returns
+        std::vector<NodeId> stack{0};
+        std::vector<NodeId> nextChild{tree.firstChild[0]}; // per open call
+        auto emit = [this](NodeId v, bool call) {
+            if (kind == ScheduleCallReturn || call == (kind == SchedulePreorder)) events.push_back({v, call});
+        };
+        emit(0, true);
+        while (!stack.empty()) {
+            const NodeId c = nextChild.back();
+            if (c != NO_NODE) {
+                nextChild.back() = tree.nextSibling[c];
+                stack.push_back(c);
+                nextChild.push_back(tree.firstChild[c]);
+                emit(c, true);
+            } else {
+                emit(stack.back(), false);
+                stack.pop_back();
+                nextChild.pop_back();
+            }
+        }
+    }
+
+    // as many checkpoints as the byte budget allows, MIN_INTERVAL events apart at least
+    words = (tree.size() + 63) / 64;
+    const size_t affordable = std::max<size_t>(1, CHECKPOINT_BYTES / (words * sizeof(uint64_t)));
+    interval = std::max(MIN_INTERVAL, (events.size() + affordable - 1) / affordable);
+    checkpoints.assign((events.size() / interval + 1) * words, 0);
+    visible.assign(words, 0);
+    for (size_t s = 0; s < events.size(); ++s) {
+        const Event& e = events[s];
+        if (shows(e)) visible[e.node >> 6] |= bitOf(e.node);
+        if ((s + 1) % interval == 0) std::copy(visible.begin(), visible.end(), checkpoints.begin() + (s + 1) / interval * words);
+    }
+    std::fill(visible.begin(), visible.end(), 0);
+}
+
+void RevealTimeline::clear() {
+    events = std::vector<Event>();
+    visible = std::vector<uint64_t>();
+    checkpoints = std::vector<uint64_t>();
+    scratch = std::vector<uint64_t>();
+    words = 0;
+    interval = 1;
+    pos = 0;
+    shown = 0;
+}
+
+// ---------------- queries ----------------
+NodeId RevealTimeline::activeNode(const CallTree& tree) const {
+    if (pos == 0) return NO_NODE;
+    const Event& e = events[pos - 1];
+    // after a return the caller is running again
+    return kind == ScheduleCallReturn && !e.call ? tree.parent[e.node] : e.node;
+}
+
+int RevealTimeline::stackDepth(const CallTree& tree) const {
+    if (pos == 0) return 0;
+    const Event& e = events[pos - 1];
+    return tree.depth[e.node] + (e.call ? 1 : 0);
+}
+
+// ---------------- seeking ----------------
+void RevealTimeline::apply(size_t index, bool forward, std::vector<NodeId>* changed) {
+    const Event& e = events[index];
+    if (!shows(e)) return;
+    if (forward) {
+        visible[e.node >> 6] |= bitOf(e.node);
+        ++shown;
+    } else {
+        visible[e.node >> 6] &= ~bitOf(e.node);
+        --shown;
+    }
+    changed->push_back(e.node);
+}
+
+void RevealTimeline::seek(size_t step, std::vector<NodeId>* changed) {
+    changed->clear();
+    step = std::min(step, events.size());
+    const size_t distance = step > pos ? step - pos : pos - step;
+    // a far seek costs about interval + words (checkpoint replay plus bitset copy and diff)
+    if (distance <= interval + words) {
+        // near: replay the events in between, in either direction
+        for (; pos < step; ++pos) apply(pos, true, changed);
+        for (; pos > step; --pos) apply(pos - 1, false, changed);
+        return;
+    }
+
+    // far: the checkpoint at or below step, replayed up to step, then diffed word by word
+    PROFILE_SCOPE("seek timeline");
+    const size_t c = step / interval;
+    scratch.assign(checkpoints.begin() + c * words, checkpoints.begin() + (c + 1) * words);
+    for (size_t s = c * interval; s < step; ++s) {
+        const Event& e = events[s];
+        if (shows(e)) scratch[e.node >> 6] |= bitOf(e.node);
+    }
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t diff = scratch[w] ^ visible[w];
+        for (NodeId v = NodeId(w * 64); diff != 0; ++v, diff >>= 1) {
+            if ((diff & 1) == 0) continue;
+            changed->push_back(v);
+            if (scratch[w] & bitOf(v)) ++shown;
+            else --shown;
+        }
+    }
+    visible.swap(scratch);
+    pos = step;
+}
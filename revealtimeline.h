@@ -0,0 +1,69 @@
+#ifndef REVEALTIMELINE_H
+#define REVEALTIMELINE_H
+
+#include <cstdint>
+#include <vector>
+#include "calltree.h"
+
+// Orders in which the nodes of a tree appear (index into comboSchedule)
+enum RevealSchedule {
+    SchedulePreorder = 0, // each node when it is called
+    ScheduleCallReturn,   // every call and every return, as the recursion runs
+    ScheduleBreadthFirst, // level by level
+    SchedulePostorder,    // each node when its call returns
+    ScheduleCount
+};
+
+// The reveal of a tree as a sequence of steps that can be replayed in both directions.
+// Step s applies event s - 1. Call events show their node and returns only pop the call
+// stack, except in post-order, whose events are the returns and show the node.
+// The visibility after every interval-th step is kept as a bitset. seek() replays the events
+// in between when that is cheaper, otherwise it restores the checkpoint below the target,
+// replays at most one interval of events and diffs the bitsets. It reports only the nodes
+// whose visibility changed. Each node shows exactly once, so a seek over d steps changes about
+// d nodes, and no seek can cost less than the changes it reports. The cost is
+// O(min(d, interval + N/64)) plus those changes, not O(log N).
+class RevealTimeline {
+public:
+    struct Event {
+        NodeId node;
+        bool call; // false: the call of node returns
+    };
+
+    // events of the schedule, positioned at step 0 (nothing visible)
+    void build(const CallTree& tree, RevealSchedule schedule);
+    void clear();
+
+    RevealSchedule schedule() const { return kind; }
+    size_t length() const { return events.size(); }
+    size_t position() const { return pos; }
+    const Event& event(size_t index) const { return events[index]; }
+    bool isVisible(NodeId node) const { return (visible[node >> 6] >> (node & 63)) & 1; }
+    size_t visibleCount() const { return shown; }
+
+    // the frame on top of the call stack after the current step, NO_NODE at step 0 or once
+    // the root returned; for the other schedules the last node shown
+    NodeId activeNode(const CallTree& tree) const;
+    // calls still open after the current step (call/return schedule only)
+    int stackDepth(const CallTree& tree) const;
+
+    // moves to step (clamped to length()); changed receives the nodes that flipped.
+    // Costs O(min(distance, interval + N/64) + changed->size()).
+    void seek(size_t step, std::vector<NodeId>* changed);
+
+private:
+    RevealSchedule kind = SchedulePreorder;
+    std::vector<Event> events;
+    std::vector<uint64_t> visible;       // bit per node
+    std::vector<uint64_t> checkpoints;   // visible after step c * interval, c = 0, 1, ...
+    std::vector<uint64_t> scratch;       // far seeks build the new state here
+    size_t words = 0;                    // per bitset
+    size_t interval = 1;
+    size_t pos = 0;
+    size_t shown = 0;
+
+    bool shows(const Event& e) const { return e.call != (kind == SchedulePostorder); }
+    void apply(size_t index, bool forward, std::vector<NodeId>* changed);
+};
+
+#endif // REVEALTIMELINE_H
@@ -0,0 +1,206 @@
+#include "subtreestore.h"
+#include "profiler.h"
+#include <algorithm>
+
+SubtreeStore::SubtreeStore(double gap, size_t limit) : vertGap(gap), maxBytes(limit) {}
+
+static size_t subtreeSize(RecurrenceRule rule, bool naive, int k) {
+    return naive ? CallTree::naiveNodeCount(rule, k) : CallTree::memoNodeCount(rule, k);
+}
+
+const char* SubtreeStore::sourceName(Source source) {
+    switch (source) {
+    case Reused: return "reused";
+    case Extracted: return "extracted from a stored tree";
+    case Composed: return "composed from stored subtrees";
+    default: return "built";
+    }
+}
+
+// ---------------- lookup ----------------
+std::shared_ptr<CallTree> SubtreeStore::tree(RecurrenceRule rule, bool naive, int k, int threads,
+                                             BuildControl* control, Source* source) {
+    if (control && control->cancel.load(std::memory_order_relaxed)) return nullptr;
+    // the lock covers lookup and insert only; copies of the locations keep their arenas alive
+    // (and unchanged) while the new tree is extracted, composed or built outside it
+    Source how = Built;
+    Location from, left, right;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (const Location* at = find(rule, naive, k)) {
+            if (at->root == 0) {
+                at->arena->lastUse = ++useClock;
+                if (control) control->nodesDone.store(at->arena->tree->size(), std::memory_order_relaxed);
+                if (source) *source = Reused;
+                return share(*at);
+            }
+            from = *at;
+            how = Extracted;
+        } else if (rule == RuleFibonacci && k >= (naive ? 2 : 3) && find(rule, naive, k - 1) &&
+                   (!naive || find(rule, naive, k - 2))) {
+            left = *find(rule, naive, k - 1);
+            if (naive) right = *find(rule, naive, k - 2);
+            how = Composed;
+        }
+    }
+
+    auto built = std::make_shared<CallTree>();
+    if (how == Extracted) {
+        // copied out once; later requests reuse the copy
+        PROFILE_SCOPE("extract subtree");
+        built->allocate(subtreeSize(rule, naive, k));
+        built->rule = rule;
+        place(*built, 0, NO_NODE, 0, 0.0, *from.arena->tree, from.root, built->size());
+    } else if (how == Composed) {
+        built = compose(naive, k, left, right);
+    } else if (naive) {
+        if (built->buildNaive(rule, k, threads, vertGap, control) == NO_NODE) return nullptr;
+    } else {
+        if (built->buildMemo(rule, k, vertGap, control) == NO_NODE) return nullptr;
+    }
+
+    Location at;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        at = {insert(naive, built), 0};
+        at.arena->lastUse = ++useClock;
+    }
+    if (control) control->nodesDone.store(built->size(), std::memory_order_relaxed);
+    if (source) *source = how;
+    return share(at);
+}
+
+const SubtreeStore::Location* SubtreeStore::find(RecurrenceRule rule, bool naive, int k) const {
+    auto it = locations.find(key(rule, naive, k));
+    return it == locations.end() ? nullptr : &it->second;
+}
+
+std::shared_ptr<CallTree> SubtreeStore::share(const Location& at) {
+    // columns view the stored arena, which the returned tree keeps alive
+    CallTree& src = *at.arena->tree;
+    auto view = std::make_shared<CallTree>();
+    const size_t count = src.size();
+    view->n.view(src.n.data(), count);
+    view->parent.view(src.parent.data(), count);
+    view->firstChild.view(src.firstChild.data(), count);
+    view->nextSibling.view(src.nextSibling.data(), count);
+    view->depth.view(src.depth.data(), count);
+    view->x.view(src.x.data(), count);
+    view->y.view(src.y.data(), count);
+    view->cached.view(src.cached.data(), count);
+    view->storage = at.arena->tree;
+    view->rule = src.rule;
+    return view;
+}
+
+void SubtreeStore::setMaxBytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxBytes = bytes;
+    // trees already handed out keep their arenas alive through CallTree::storage
+    evict(nullptr);
+}
+
+size_t SubtreeStore::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t total = 0;
+    for (const auto &arena : arenas) total += arena->bytes;
+    return total;
+}
+
+// ---------------- storing ----------------
+std::shared_ptr<SubtreeStore::Arena> SubtreeStore::insert(bool naive, const std::shared_ptr<CallTree>& tree) {
+    auto arena = std::make_shared<Arena>();
+    arena->tree = tree;
+    arena->bytes = tree->size() * CallTree::NODE_BYTES;
+    arenas.push_back(arena);
+
+    // T(k) at the root owns its key; the first-child chain below it is registered unless
+    // already stored elsewhere. For Fibonacci that chain F(k-1)..F(1) and the F(0) under F(2)
+    // are the roots of every smaller tree.
+    const CallTree& t = *tree;
+    const RecurrenceRule rule = t.rule;
+    locations[key(rule, naive, t.n[0])] = {arena, 0};
+    for (NodeId v = t.firstChild[0]; v != NO_NODE; v = t.firstChild[v]) {
+        locations.insert({key(rule, naive, t.n[v]), {arena, v}});
+        if (rule == RuleFibonacci && t.n[v] == 2) {
+            const NodeId zero = t.nextSibling[t.firstChild[v]];
+            locations.insert({key(rule, naive, t.n[zero]), {arena, zero}});
+        }
+    }
+    evict(arena);
+    return arena;
+}
+
+void SubtreeStore::evict(const std::shared_ptr<Arena>& keep) {
+    size_t total = 0;
+    for (const auto &arena : arenas) total += arena->bytes;
+    // least recently served arenas go first, with every location inside them
+    std::sort(arenas.begin(), arenas.end(), [](const auto& a, const auto& b) { return a->lastUse < b->lastUse; });
+    for (auto it = arenas.begin(); it != arenas.end() && total > maxBytes;) {
+        if (*it == keep) {
+            ++it;
+            continue;
+        }
+        for (auto loc = locations.begin(); loc != locations.end();) {
+            loc = loc->second.arena == *it ? locations.erase(loc) : std::next(loc);
+        }
+        total -= (*it)->bytes;
+        it = arenas.erase(it);
+    }
+}
+
+// ---------------- composing ----------------
+std::shared_ptr<CallTree> SubtreeStore::compose(bool naive, int k, const Location& left, const Location& right) const {
+    PROFILE_SCOPE("compose subtree");
+    const size_t leftSize = subtreeSize(RuleFibonacci, naive, k - 1);
+    auto t = std::make_shared<CallTree>();
+    t->allocate(subtreeSize(RuleFibonacci, naive, k));
+    t->n[0] = k;
+    t->y[0] = 0.0;
+
+    // the F(k-1) tree, then F(k-2) right of its last leaf (the last node in preorder)
+    const NodeId second = place(*t, 1, 0, 1, 0.0, *left.arena->tree, left.root, leftSize);
+    const double slot = t->x[second - 1] + 1.0;
+    if (naive) {
+        place(*t, second, 0, 1, slot, *right.arena->tree, right.root, subtreeSize(RuleFibonacci, naive, k - 2));
+    } else {
+        // the memo table answers F(k-2): a cached leaf
+        t->n[second] = k - 2;
+        t->parent[second] = 0;
+        t->depth[second] = 1;
+        t->x[second] = slot;
+        t->y[second] = vertGap;
+        t->cached[second] = 1;
+    }
+    t->firstChild[0] = 1;
+    t->nextSibling[1] = second;
+    t->x[0] = (t->x[1] + t->x[second]) / 2.0;
+    return t;
+}
+
+NodeId SubtreeStore::place(CallTree& dst, NodeId dstId, NodeId parent, int depth0, double slot0,
+                           const CallTree& src, NodeId srcRoot, size_t count) const {
+    // ids shift by a constant; x moves the subtree's first leaf to slot0
+    NodeId leaf = srcRoot;
+    while (src.firstChild[leaf] != NO_NODE) leaf = src.firstChild[leaf];
+    const double dx = slot0 - src.x[leaf];
+    const int dDepth = depth0 - src.depth[srcRoot];
+    const NodeId shift = dstId - srcRoot; // modular, so it also moves ids down
+    auto moved = [shift](NodeId id) { return id == NO_NODE ? NO_NODE : NodeId(id + shift); };
+
+    for (size_t i = 0; i < count; ++i) {
+        const NodeId s = srcRoot + NodeId(i), d = dstId + NodeId(i);
+        dst.n[d] = src.n[s];
+        dst.parent[d] = moved(src.parent[s]);
+        dst.firstChild[d] = moved(src.firstChild[s]);
+        dst.nextSibling[d] = moved(src.nextSibling[s]);
+        dst.depth[d] = src.depth[s] + dDepth;
+        dst.x[d] = src.x[s] + dx;
+        dst.y[d] = dst.depth[d] * vertGap;
+        dst.cached[d] = src.cached[s];
+    }
+    // the subtree root's links pointed outside the copied range
+    dst.parent[dstId] = parent;
+    dst.nextSibling[dstId] = NO_NODE;
+    return dstId + NodeId(count);
+}
@@ -0,0 +1,75 @@
+#ifndef SUBTREESTORE_H
+#define SUBTREESTORE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "calltree.h"
+
+// Hash-consed store of laid-out call trees, keyed by (rule, naive or memo, k).
+// Every T(j) subtree is a contiguous preorder range, and the first call of a tree starts with
+// nothing memoized, so a stored arena also holds the trees of its first-child chain (for
+// Fibonacci every smaller tree of its mode). Layouts are translation invariant (leaf slots,
+// parents centred over their children), so a placed subtree equals a fresh one.
+// Requests are served, cheapest first, as:
+//   Reused     a whole stored arena, shared by viewing its columns (no copy)
+//   Extracted  a subtree of a larger arena, copied out with rebased ids
+//   Composed   a new root over the stored child subtrees, copied in by offset (Fibonacci only:
+//              the naive F(k) tree is a root over F(k-1) and F(k-2), the memo one over F(k-1)
+//              and a cached leaf)
+//   Built      the regular builders, when a child is missing
+// Safe to call from several threads: the lock is held for lookups and inserts only, never while
+// a tree is built, so a slow or cancelled build does not hold up other requests. Built trees are
+// never written afterwards.
+class SubtreeStore {
+public:
+    enum Source { Reused, Extracted, Composed, Built };
+
+    SubtreeStore(double vertGap, size_t maxBytes);
+
+    // The tree of T(k) of a rule, viewing stored memory (do not write to it); nullptr when
+    // cancelled. threads is handed to the parallel naive builder.
+    std::shared_ptr<CallTree> tree(RecurrenceRule rule, bool naive, int k, int threads,
+                                   BuildControl* control = nullptr, Source* source = nullptr);
+    // stored arenas are evicted, least recently served first, until they fit the new cap
+    void setMaxBytes(size_t bytes);
+    size_t bytes() const;
+
+    static const char* sourceName(Source source);
+
+private:
+    struct Arena {
+        std::shared_ptr<CallTree> tree;
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+    struct Location {
+        std::shared_ptr<Arena> arena;
+        NodeId root = 0; // of the T(k) subtree inside the arena
+    };
+
+    double vertGap;
+    size_t maxBytes;
+    mutable std::mutex mutex;
+    std::unordered_map<int, Location> locations; // by key()
+    std::vector<std::shared_ptr<Arena>> arenas;
+    uint64_t useClock = 0;
+
+    static int key(RecurrenceRule rule, bool naive, int k) { return 2 * (k * RuleCount + rule) + (naive ? 1 : 0); }
+    const Location* find(RecurrenceRule rule, bool naive, int k) const;
+    // store a new arena holding T(k) at its root, registering its smaller subtrees too
+    std::shared_ptr<Arena> insert(bool naive, const std::shared_ptr<CallTree>& tree);
+    // down to maxBytes; keep (null for none) is the arena just served and stays
+    void evict(const std::shared_ptr<Arena>& keep);
+    // a root over the stored F(k-1) and, for naive trees, F(k-2); runs without the lock
+    std::shared_ptr<CallTree> compose(bool naive, int k, const Location& left, const Location& right) const;
+    static std::shared_ptr<CallTree> share(const Location& at);
+    // copy the count-node subtree at src[srcRoot] to dst[dstId], under parent at depth0,
+    // its leaves starting at leaf slot slot0; returns the id after the copy
+    NodeId place(CallTree& dst, NodeId dstId, NodeId parent, int depth0, double slot0,
+                 const CallTree& src, NodeId srcRoot, size_t count) const;
+};
+
+#endif // SUBTREESTORE_H
@@ -0,0 +1,152 @@
+#include "tilecache.h"
+#include <QPainter>
+#include <QRegion>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// rendered tiles kept across all levels (256 KB each)
+static const size_t MAX_TILES = 512;
+
+TileCache::TileCache(QObject* parent) : QObject(parent) {
+    // leave one core to the GUI thread
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+TileCache::~TileCache() {
+    pool.clear();
+    pool.waitForDone();
+}
+
+int TileCache::levelFor(double lod) {
+    int level = int(std::ceil(std::log2(std::max(lod, 1e-12))));
+    return std::clamp(level, MIN_LEVEL, -1);
+}
+
+quint64 TileCache::keyOf(int level, int tx, int ty) {
+    return (quint64(-level) << 56) | (quint64(quint32(tx)) << 24) | quint64(quint32(ty) & 0xFFFFFF);
+}
+
+QRectF TileCache::tileRect(int level, int tx, int ty) {
+    const double side = TILE_PX / std::ldexp(1.0, level);
+    return QRectF(tx * side, ty * side, side, side);
+}
+
+// ---------------- drawing ----------------
+void TileCache::draw(QPainter* painter, const QRectF& exposed, int level, const RenderFn& render, const FallbackFn& fallback) {
+    const double side = TILE_PX / std::ldexp(1.0, level);
+    const int tx0 = int(std::floor(exposed.left() / side)), tx1 = int(std::floor(exposed.right() / side));
+    const int ty0 = int(std::floor(exposed.top() / side)), ty1 = int(std::floor(exposed.bottom() / side));
+    ++useClock;
+
+    QRegion missing; // scene coordinates; tiles are hundreds of scene units wide
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            const QRectF rect = tileRect(level, tx, ty);
+            Tile &tile = tiles[keyOf(level, tx, ty)];
+            tile.lastUse = useClock;
+            if (!tile.image.isNull()) {
+                painter->drawImage(rect, tile.image);
+                continue;
+            }
+            missing += rect.toAlignedRect();
+            if (tile.pending) continue;
+
+            // render on the pool; the result is handed back through the event loop
+            tile.pending = true;
+            levelsUsed |= 1u << (-level - 1);
+            const quint64 key = keyOf(level, tx, ty), generation = tile.generation;
+            RenderFn job = render;
+            pool.start([this, job, key, generation, level, tx, ty, rect]() {
+                QImage image(TILE_PX, TILE_PX, QImage::Format_ARGB32_Premultiplied);
+                image.fill(Qt::transparent);
+                {
+                    QPainter p(&image);
+                    p.setRenderHint(QPainter::Antialiasing);
+                    const double scale = std::ldexp(1.0, level);
+                    p.scale(scale, scale);
+                    p.translate(-rect.topLeft());
+                    p.setClipRect(rect);
+                    job(&p, rect);
+                }
+                QMetaObject::invokeMethod(this, [this, key, generation, level, tx, ty, image]() {
+                    tileDone(key, generation, level, tx, ty, image);
+                }, Qt::QueuedConnection);
+            });
+        }
+    }
+    painter->restore();
+
+    if (!missing.isEmpty()) {
+        // the uncached part is painted the slow way this once
+        painter->save();
+        painter->setClipRegion(missing, Qt::IntersectClip);
+        fallback(QRectF(missing.boundingRect()).intersected(exposed));
+        painter->restore();
+    }
+}
+
+void TileCache::tileDone(quint64 key, quint64 generation, int level, int tx, int ty, const QImage& image) {
+    auto it = tiles.find(key);
+    if (it == tiles.end()) return; // cleared meanwhile
+    it->second.pending = false;
+    // invalidated while rendering: the next paint asks again
+    if (it->second.generation == generation) it->second.image = image;
+    evict();
+    emit tileReady(tileRect(level, tx, ty));
+}
+
+// ---------------- invalidation ----------------
+void TileCache::invalidate(const QRectF& sceneRect) {
+    for (int level = -1; level >= MIN_LEVEL; --level) {
+        if (!(levelsUsed & (1u << (-level - 1)))) continue;
+        const double side = TILE_PX / std::ldexp(1.0, level);
+        const int tx0 = int(std::floor(sceneRect.left() / side)), tx1 = int(std::floor(sceneRect.right() / side));
+        const int ty0 = int(std::floor(sceneRect.top() / side)), ty1 = int(std::floor(sceneRect.bottom() / side));
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                auto it = tiles.find(keyOf(level, tx, ty));
+                if (it == tiles.end()) continue;
+                if (it->second.pending) {
+                    ++it->second.generation;
+                    it->second.image = QImage();
+                } else {
+                    tiles.erase(it);
+                }
+            }
+        }
+    }
+}
+
+void TileCache::clear() {
+    // tiles in flight come back with an old generation and are dropped
+    for (auto it = tiles.begin(); it != tiles.end();) {
+        if (it->second.pending) {
+            ++it->second.generation;
+            it->second.image = QImage();
+            ++it;
+        } else {
+            it = tiles.erase(it);
+        }
+    }
+}
+
+void TileCache::evict() {
+    size_t rendered = 0;
+    for (const auto &entry : tiles) rendered += entry.second.image.isNull() ? 0 : 1;
+    if (rendered <= MAX_TILES) return;
+    // drop the least recently blitted tiles down to the limit
+    std::vector<std::pair<quint64, quint64>> byUse; // lastUse, key
+    for (const auto &entry : tiles) {
+        if (!entry.second.pending) byUse.push_back({entry.second.lastUse, entry.first});
+    }
+    std::sort(byUse.begin(), byUse.end());
+    for (size_t i = 0; i < byUse.size() && rendered > MAX_TILES; ++i) {
+        auto it = tiles.find(byUse[i].second);
+        if (!it->second.image.isNull()) --rendered;
+        tiles.erase(it);
+    }
+}
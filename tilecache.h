@@ -0,0 +1,59 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QRectF>
+#include <QThreadPool>
+#include <functional>
+#include <unordered_map>
+
+class QPainter;
+
+// Multi-resolution raster cache for a scene item. Level L holds tiles of TILE_PX pixels
+// rendered at scale 2^L (L < 0, zoomed out); a view at zoom lod uses the smallest level
+// whose scale is at least lod and blits its tiles. Missing tiles are rendered on a
+// thread pool and painted directly meanwhile; invalidate() drops the tiles under a rect.
+class TileCache : public QObject {
+    Q_OBJECT
+public:
+    static const int TILE_PX = 256;
+    static const int MIN_LEVEL = -20; // tiles 2^28 scene units wide; QRegion needs int coordinates
+
+    explicit TileCache(QObject* parent = nullptr);
+    ~TileCache() override; // waits for tiles still being rendered
+
+    // Draws one tile's scene rect into a painter already set up for it. Runs on a pool
+    // thread, so it may only read data that stays alive and unchanged (capture snapshots).
+    using RenderFn = std::function<void(QPainter* painter, const QRectF& sceneRect)>;
+    // Paints directly what is not cached yet (called at most once per draw, clipped)
+    using FallbackFn = std::function<void(const QRectF& sceneRect)>;
+
+    static int levelFor(double lod);
+    void draw(QPainter* painter, const QRectF& exposed, int level, const RenderFn& render, const FallbackFn& fallback);
+    void invalidate(const QRectF& sceneRect);
+    void clear();
+
+signals:
+    // a tile finished rendering; the owner repaints this scene rect
+    void tileReady(const QRectF& sceneRect);
+
+private:
+    struct Tile {
+        QImage image;          // null until rendered (or after invalidation)
+        quint64 generation = 0;
+        quint64 lastUse = 0;
+        bool pending = false;
+    };
+    std::unordered_map<quint64, Tile> tiles;
+    quint32 levelsUsed = 0; // bit (-level - 1) set when the level has tiles
+    quint64 useClock = 0;
+    QThreadPool pool;
+
+    static quint64 keyOf(int level, int tx, int ty);
+    static QRectF tileRect(int level, int tx, int ty);
+    void tileDone(quint64 key, quint64 generation, int level, int tx, int ty, const QImage& image);
+    void evict();
+};
+
+#endif // TILECACHE_H
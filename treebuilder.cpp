@@ -0,0 +1,139 @@
+#include "treebuilder.h"
+#include "bigint.h"
+#include "nodeitem.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include <algorithm>
+
+static const int PROGRESS_INTERVAL = 50; // ms between progress updates
+// longer values are shown as a summary; printing all digits is quadratic
+static const size_t MAX_VALUE_DIGITS = 2000;
+
+struct TreeBuilder::Job {
+    RecurrenceRule rule = RuleFibonacci;
+    int n = 0;
+    bool naive = true;
+    int threads = 1;
+    size_t total = 0;
+    BuildControl control;
+    // written by the worker, read on the GUI thread after the thread has finished
+    std::shared_ptr<CallTree> tree;
+    std::shared_ptr<FibValueResult> value; // startValue() jobs instead of tree
+    double ms = 0.0;
+    SubtreeStore::Source source = SubtreeStore::Built;
+};
+
+TreeBuilder::TreeBuilder(QObject* parent)
+    // nothing is kept beyond the last served tree until the owner sets a limit
+    : QObject(parent), store(std::make_shared<SubtreeStore>(V_GAP, 0)) {
+    threads = std::max(1, QThread::idealThreadCount());
+    progressTimer.setInterval(PROGRESS_INTERVAL);
+    connect(&progressTimer, &QTimer::timeout, this, &TreeBuilder::pollProgress);
+}
+
+TreeBuilder::~TreeBuilder() {
+    // workers check the cancel flag every few thousand nodes, so this is short
+    cancel();
+    for (QThread* t : running) {
+        t->wait();
+        delete t;
+    }
+}
+
+void TreeBuilder::setThreadCount(int count) {
+    threads = std::max(1, count);
+}
+
+void TreeBuilder::start(RecurrenceRule rule, int n, bool naive) {
+    cancel();
+    auto job = std::make_shared<Job>();
+    job->rule = rule;
+    job->n = n;
+    job->naive = naive;
+    job->threads = threads;
+    job->total = naive ? CallTree::naiveNodeCount(rule, n) : CallTree::memoNodeCount(rule, n);
+    current = job;
+
+    // stored trees are shared or composed; only trees with no stored children are built
+    QThread* thread = QThread::create([job, store = store]() {
+        QElapsedTimer timer;
+        timer.start();
+        std::shared_ptr<CallTree> tree = store->tree(job->rule, job->naive, job->n, job->threads,
+                                                     &job->control, &job->source);
+        if (!tree || job->control.cancel.load()) return;
+        job->ms = timer.nsecsElapsed() / 1e6;
+        job->tree = std::move(tree);
+    });
+    launch(job, thread);
+}
+
+void TreeBuilder::startValue(int n, bool compareLinear) {
+    cancel();
+    auto job = std::make_shared<Job>();
+    job->n = n;
+    current = job;
+
+    // both algorithms check the cancel flag between steps
+    QThread* thread = QThread::create([job, compareLinear]() {
+        const std::atomic<bool>* cancel = &job->control.cancel;
+        auto result = std::make_shared<FibValueResult>();
+        result->n = job->n;
+        QElapsedTimer timer;
+        timer.start();
+        const BigUInt value = fibFastDoubling(uint64_t(job->n), cancel);
+        result->doublingMs = timer.nsecsElapsed() / 1e6;
+        if (compareLinear && !cancel->load()) {
+            timer.restart();
+            const BigUInt check = fibLinear(uint64_t(job->n), cancel);
+            result->linearMs = timer.nsecsElapsed() / 1e6;
+            result->agree = check == value;
+        }
+        if (cancel->load()) return;
+        result->digits = value.decimalDigits();
+        result->bits = value.bitLength();
+        result->text = result->digits <= MAX_VALUE_DIGITS ? value.toString() : value.summary();
+        job->value = std::move(result);
+    });
+    launch(job, thread);
+}
+
+void TreeBuilder::launch(const std::shared_ptr<Job>& job, QThread* thread) {
+    running.push_back(thread);
+    // QThread::finished is emitted on the worker; the receiver context queues the lambda to us
+    connect(thread, &QThread::finished, this, [this, job, thread]() { jobDone(job, thread); });
+    thread->start();
+
+    emit progress(0);
+    progressTimer.start();
+}
+
+void TreeBuilder::cancel() {
+    if (!current) return;
+    current->control.cancel.store(true);
+    current.reset();
+    progressTimer.stop();
+}
+
+void TreeBuilder::pollProgress() {
+    if (!current || current->total == 0) return;
+    // building is most of the work; the last few percent are layout
+    size_t done = current->control.nodesDone.load(std::memory_order_relaxed);
+    emit progress(int(std::min<size_t>(95, done * 95 / current->total)));
+}
+
+void TreeBuilder::jobDone(const std::shared_ptr<Job>& job, QThread* thread) {
+    running.erase(std::remove(running.begin(), running.end(), thread), running.end());
+    thread->deleteLater();
+    if (job != current) return; // cancelled or superseded
+
+    current.reset();
+    progressTimer.stop();
+    if (job->value) {
+        emit progress(100);
+        emit valueFinished(std::move(job->value));
+        return;
+    }
+    if (!job->tree) return;
+    emit progress(100);
+    emit finished(std::move(job->tree), job->ms, job->source);
+}
@@ -0,0 +1,71 @@
+#ifndef TREEBUILDER_H
+#define TREEBUILDER_H
+
+#include <QObject>
+#include <QTimer>
+#include <memory>
+#include <string>
+#include <vector>
+#include "calltree.h"
+#include "subtreestore.h"
+
+class QThread;
+
+// F(n) computed on the builder's worker for the value-only view, ready to show
+struct FibValueResult {
+    int n = 0;
+    std::string text;      // all digits, or a summary of long values
+    size_t digits = 0;
+    size_t bits = 0;
+    double doublingMs = 0.0;
+    double linearMs = -1.0; // < 0: the linear loop was not run
+    bool agree = true;      // the linear loop gave the same value
+};
+
+// Builds and lays out a CallTree on a worker thread, through a SubtreeStore that keeps
+// every tree it has made: redraws and neighbouring n reuse or compose stored subtrees.
+// The finished tree is handed over whole and never touched by the worker again.
+// Every start() gets its own job, so a cancelled or superseded build simply runs
+// out in the background and its result is dropped. startValue() runs the big-integer
+// F(n) of the value-only view the same way, so long values keep the window responsive.
+class TreeBuilder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TreeBuilder(QObject* parent = nullptr);
+    ~TreeBuilder() override;
+
+    // cancels the running build, if any
+    void start(RecurrenceRule rule, int n, bool naive);
+    // F(n) by fast doubling, timed against the linear loop when compareLinear; cancels as start()
+    void startValue(int n, bool compareLinear);
+    void cancel();
+    bool isRunning() const { return current != nullptr; }
+    // workers used for naive trees (memo trees are linear and built by one thread)
+    int threadCount() const { return threads; }
+    void setThreadCount(int count);
+    // memory held by stored trees, which the resource governor charges to its budget
+    size_t storeBytes() const { return store->bytes(); }
+    // cap on that memory, derived from the budget (ResourceGovernor::storeBudget)
+    void setStoreLimit(size_t bytes) { store->setMaxBytes(bytes); }
+
+signals:
+    void progress(int percent);
+    // tree views stored memory and must not be written; ms covers build and layout
+    void finished(std::shared_ptr<CallTree> tree, double ms, SubtreeStore::Source source);
+    void valueFinished(std::shared_ptr<const FibValueResult> result);
+
+private:
+    struct Job;
+    std::shared_ptr<Job> current;
+    std::shared_ptr<SubtreeStore> store; // shared with running jobs
+    std::vector<QThread*> running; // still running, including superseded jobs
+    int threads = 1;
+    QTimer progressTimer;
+
+    void launch(const std::shared_ptr<Job>& job, QThread* thread);
+    void pollProgress();
+    void jobDone(const std::shared_ptr<Job>& job, QThread* thread);
+};
+
+#endif // TREEBUILDER_H
@@ -0,0 +1,181 @@
+#include "treeexport.h"
+#include "nodeitem.h"
+#include "fibvalues.h"
+#include "recurrence.h"
+#include <QFont>
+#include <QImage>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QSaveFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// SVG labels are left out above this many nodes (they dominate the file size)
+static const size_t SVG_LABEL_LIMIT = 1 << 16;
+// PNG: nodes narrower than this many pixels become dots, wider ones get labels from LOD_LABELS
+static const double PNG_DOT_PX = 6.0;
+static const double LOD_LABELS = 0.45;
+// lines and points handed to QPainter per call
+static const size_t PNG_BATCH = 4096;
+
+static bool fail(QString* error, const QString& text) {
+    if (error) *error = text;
+    return false;
+}
+
+static QRectF treeBounds(const CallTree& tree) {
+    auto [minX, maxX] = std::minmax_element(tree.x.begin(), tree.x.end());
+    const double maxY = *std::max_element(tree.y.begin(), tree.y.end());
+    return QRectF(*minX * H_GAP - NODE_HALF_W, -NODE_HALF_H,
+                  (*maxX - *minX) * H_GAP + 2 * NODE_HALF_W, maxY + 2 * NODE_HALF_H);
+}
+
+static QPointF nodePos(const CallTree& tree, NodeId id) {
+    return QPointF(tree.x[id] * H_GAP, tree.y[id]);
+}
+
+// ---------------- SVG ----------------
+bool exportTreeSvg(const CallTree& tree, const QString& path, QString* error) {
+    if (tree.empty()) return fail(error, "There is no tree to export.");
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return fail(error, file.errorString());
+
+    const QRectF b = treeBounds(tree);
+    const bool labels = tree.size() <= SVG_LABEL_LIMIT;
+    QTextStream out(&file);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(1);
+
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"" << b.left() << ' ' << b.top() << ' '
+        << b.width() << ' ' << b.height() << "\" width=\"" << b.width() << "\" height=\"" << b.height() << "\">\n"
+        << "<defs>\n"
+        << "<linearGradient id=\"gn\" x1=\"0\" y1=\"0\" x2=\"1\" y2=\"1\">"
+           "<stop offset=\"0\" stop-color=\"#334197\"/><stop offset=\"1\" stop-color=\"#14B8A6\"/></linearGradient>\n"
+        << "<linearGradient id=\"gc\" x1=\"0\" y1=\"0\" x2=\"1\" y2=\"1\">"
+           "<stop offset=\"0\" stop-color=\"#5F697D\"/><stop offset=\"1\" stop-color=\"#414B5F\"/></linearGradient>\n"
+        << "<style>line{stroke:#000;stroke-width:1}.d{stroke-dasharray:6 4}"
+           "ellipse{stroke:#F0F4F9;stroke-width:1;fill:url(#gn)}.c{fill:url(#gc)}"
+           "text{font-family:'Segoe UI',sans-serif;text-anchor:middle;fill:#FAFAFC}"
+           ".l{font-size:14px;font-weight:bold}.v{font-size:11px;fill:#C8DCEB}</style>\n"
+        << "</defs>\n"
+        << "<rect x=\"" << b.left() << "\" y=\"" << b.top() << "\" width=\"" << b.width()
+        << "\" height=\"" << b.height() << "\" fill=\"#fff\"/>\n";
+
+    // edges first so nodes cover their ends; dashed for cached calls
+    out << "<g>\n";
+    for (NodeId c = 1; c < tree.size(); ++c) {
+        const NodeId p = tree.parent[c];
+        if (p == NO_NODE) continue;
+        const QPointF a = nodePos(tree, p), z = nodePos(tree, c);
+        out << "<line" << (tree.cached[c] ? " class=\"d\"" : "") << " x1=\"" << a.x() << "\" y1=\"" << a.y()
+            << "\" x2=\"" << z.x() << "\" y2=\"" << z.y() << "\"/>\n";
+    }
+    out << "</g>\n<g>\n";
+    const char symbol = recurrenceSymbol(tree.rule);
+    for (NodeId v = 0; v < tree.size(); ++v) {
+        const QPointF c = nodePos(tree, v);
+        out << "<ellipse" << (tree.cached[v] ? " class=\"c\"" : "") << " cx=\"" << c.x() << "\" cy=\"" << c.y()
+            << "\" rx=\"" << NODE_HALF_W << "\" ry=\"" << NODE_HALF_H << "\"/>\n";
+        if (labels) {
+            out << "<text class=\"l\" x=\"" << c.x() << "\" y=\"" << c.y() - 2 << "\">" << symbol << "(" << tree.n[v] << ")</text>"
+                << "<text class=\"v\" x=\"" << c.x() << "\" y=\"" << c.y() + 14 << "\">"
+                << QString::fromStdString(valueLabel(tree.rule, tree.n[v])) << "</text>\n";
+        }
+    }
+    out << "</g>\n</svg>\n";
+    out.flush();
+
+    if (out.status() != QTextStream::Ok) {
+        file.cancelWriting();
+        return fail(error, file.errorString());
+    }
+    if (!file.commit()) return fail(error, file.errorString());
+    return true;
+}
+
+// ---------------- PNG ----------------
+bool exportTreePng(const CallTree& tree, const QString& path, int maxSide, QString* error) {
+    if (tree.empty()) return fail(error, "There is no tree to export.");
+    const QRectF b = treeBounds(tree);
+    const double scale = std::min(1.0, maxSide / std::max(b.width(), b.height()));
+    QImage image(std::max(1, int(std::ceil(b.width() * scale))), std::max(1, int(std::ceil(b.height() * scale))),
+                 QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) return fail(error, "Not enough memory for an image of that size.");
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.scale(scale, scale);
+    painter.translate(-b.topLeft());
+    const bool dots = 2 * NODE_HALF_W * scale < PNG_DOT_PX;
+
+    // edges, flushed in batches so memory stays flat however large the tree is
+    std::vector<QLineF> solid, dashed;
+    solid.reserve(PNG_BATCH);
+    dashed.reserve(PNG_BATCH);
+    QPen solidPen(QColor(0, 0, 0), dots ? 0 : 1);
+    QPen dashedPen = solidPen;
+    dashedPen.setStyle(Qt::DashLine);
+    auto flushLines = [&painter](std::vector<QLineF>& lines, const QPen& pen) {
+        painter.setPen(pen);
+        painter.drawLines(lines.data(), int(lines.size()));
+        lines.clear();
+    };
+    for (NodeId c = 1; c < tree.size(); ++c) {
+        const NodeId p = tree.parent[c];
+        if (p == NO_NODE) continue;
+        std::vector<QLineF> &batch = tree.cached[c] ? dashed : solid;
+        batch.emplace_back(nodePos(tree, p), nodePos(tree, c));
+        if (batch.size() == PNG_BATCH) flushLines(batch, tree.cached[c] ? dashedPen : solidPen);
+    }
+    flushLines(solid, solidPen);
+    flushLines(dashed, dashedPen);
+
+    if (dots) {
+        // at this scale a node is a few pixels: one point per node, in two colours
+        std::vector<QPointF> points[2];
+        const QColor colors[2] = {QColor(20, 184, 166), QColor(95, 105, 125)};
+        auto flushPoints = [&](int style) {
+            painter.setPen(QPen(colors[style], PNG_DOT_PX / scale * 0.5, Qt::SolidLine, Qt::RoundCap));
+            painter.drawPoints(points[style].data(), int(points[style].size()));
+            points[style].clear();
+        };
+        for (NodeId v = 0; v < tree.size(); ++v) {
+            const int style = tree.cached[v] ? 1 : 0;
+            points[style].push_back(nodePos(tree, v));
+            if (points[style].size() == PNG_BATCH) flushPoints(style);
+        }
+        flushPoints(0);
+        flushPoints(1);
+    } else {
+        QLinearGradient normal(0, 0, 1, 1), cachedGrad(0, 0, 1, 1);
+        normal.setCoordinateMode(QGradient::ObjectBoundingMode);
+        normal.setColorAt(0.0, QColor(51, 65, 151));
+        normal.setColorAt(1.0, QColor(20, 184, 166));
+        cachedGrad.setCoordinateMode(QGradient::ObjectBoundingMode);
+        cachedGrad.setColorAt(0.0, QColor(95, 105, 125));
+        cachedGrad.setColorAt(1.0, QColor(65, 75, 95));
+        const QBrush brushes[2] = {QBrush(normal), QBrush(cachedGrad)};
+        const bool labels = scale >= LOD_LABELS;
+        const QFont labelFont("Segoe UI", 10, QFont::Bold);
+        painter.setFont(labelFont);
+        for (NodeId v = 0; v < tree.size(); ++v) {
+            const QPointF c = nodePos(tree, v);
+            const QRectF r(c.x() - NODE_HALF_W, c.y() - NODE_HALF_H, 2 * NODE_HALF_W, 2 * NODE_HALF_H);
+            painter.setPen(QPen(QColor(240, 244, 249), 1));
+            painter.setBrush(brushes[tree.cached[v] ? 1 : 0]);
+            painter.drawEllipse(r);
+            if (labels) {
+                painter.setPen(QColor(250, 250, 252));
+                painter.drawText(r, Qt::AlignCenter, QString("%1(%2)").arg(QChar(recurrenceSymbol(tree.rule))).arg(tree.n[v]));
+            }
+        }
+    }
+    painter.end();
+
+    if (!image.save(path, "PNG")) return fail(error, QString("Could not write %1").arg(path));
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef TREEEXPORT_H
+#define TREEEXPORT_H
+
+#include <QString>
+#include "calltree.h"
+
+// Exporters that stream straight from the arena (possibly a mapped tree file) in preorder,
+// without a QGraphicsScene or any NodeItem. Every node is drawn regardless of reveal state.
+
+// SVG with one element per edge and node; labels are left out for very large trees
+bool exportTreeSvg(const CallTree& tree, const QString& path, QString* error = nullptr);
+// PNG whose longer side is at most maxSide pixels; detail follows the resulting scale
+bool exportTreePng(const CallTree& tree, const QString& path, int maxSide, QString* error = nullptr);
+
+#endif // TREEEXPORT_H
@@ -0,0 +1,163 @@
+#include "treefile.h"
+#include <QFile>
+#include <QSaveFile>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+static const char TREE_FILE_MAGIC[8] = {'F', 'I', 'B', 'T', 'R', 'E', 'E', '\0'};
+static const quint32 BYTE_ORDER_MARK = 0x01020304;
+static const qint64 COLUMN_ALIGN = 64;
+static const int COLUMN_COUNT = 8;
+
+namespace {
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 nodeCount;
+    qint32 rootN;
+    quint32 flags;                 // FlagMemo, and the recurrence rule from bit RULE_SHIFT
+    double vertGap;
+    quint64 offsets[COLUMN_COUNT]; // file offset of each column, in CallTree member order
+};
+static_assert(sizeof(Header) == 104, "tree file header layout changed");
+
+enum : quint32 { FlagMemo = 1 };
+// files written before other rules existed have zero here, which is Fibonacci
+const int RULE_SHIFT = 8;
+
+// element sizes in column order
+const size_t ELEMENT_SIZE[COLUMN_COUNT] = {
+    sizeof(int), sizeof(NodeId), sizeof(NodeId), sizeof(NodeId),
+    sizeof(int), sizeof(double), sizeof(double), sizeof(std::uint8_t)
+};
+
+qint64 alignUp(qint64 pos) {
+    return (pos + COLUMN_ALIGN - 1) / COLUMN_ALIGN * COLUMN_ALIGN;
+}
+
+// One linear pass over the mapped columns: links stay inside the arena and follow preorder
+// (parents and earlier siblings precede a node, so sibling chains cannot loop), depths match
+// the parents, and no call computes a larger k than the root, which a tree this size can hold
+// (every rule's calls lower k by at most 3).
+bool validColumns(const CallTree& t) {
+    const NodeId count = NodeId(t.size());
+    if (t.parent[0] != NO_NODE || t.depth[0] != 0 || t.n[0] < 0 || size_t(t.n[0]) >= 3 * t.size()) return false;
+    for (NodeId v = 0; v < count; ++v) {
+        const NodeId p = t.parent[v], c = t.firstChild[v], s = t.nextSibling[v];
+        if (v > 0 && (p >= v || t.depth[v] != t.depth[p] + 1)) return false;
+        if (c != NO_NODE && (c <= v || c >= count || t.parent[c] != v)) return false;
+        if (s != NO_NODE && (s <= v || s >= count || t.parent[s] != p)) return false;
+        if (t.n[v] < 0 || t.n[v] > t.n[0] || !std::isfinite(t.x[v]) || !std::isfinite(t.y[v])) return false;
+    }
+    return true;
+}
+
+bool fail(QString* error, const QString& text) {
+    if (error) *error = text;
+    return false;
+}
+
+} // namespace
+
+// ---------------- save ----------------
+bool saveTreeFile(const QString& path, const CallTree& tree, bool memo, double vertGap, QString* error) {
+    if (tree.empty()) return fail(error, "There is no tree to save.");
+    const char* columns[COLUMN_COUNT] = {
+        reinterpret_cast<const char*>(tree.n.data()), reinterpret_cast<const char*>(tree.parent.data()),
+        reinterpret_cast<const char*>(tree.firstChild.data()), reinterpret_cast<const char*>(tree.nextSibling.data()),
+        reinterpret_cast<const char*>(tree.depth.data()), reinterpret_cast<const char*>(tree.x.data()),
+        reinterpret_cast<const char*>(tree.y.data()), reinterpret_cast<const char*>(tree.cached.data())
+    };
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TREE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TREE_FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.nodeCount = tree.size();
+    header.rootN = tree.n[0];
+    header.flags = (memo ? FlagMemo : 0) | quint32(tree.rule) << RULE_SHIFT;
+    header.vertGap = vertGap;
+    qint64 pos = alignUp(sizeof(Header));
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        header.offsets[c] = quint64(pos);
+        pos = alignUp(pos + qint64(tree.size() * ELEMENT_SIZE[c]));
+    }
+
+    // written to a temporary file and renamed on commit, so a failed save leaves no partial tree
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return fail(error, file.errorString());
+    static const char padding[COLUMN_ALIGN] = {};
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == qint64(sizeof(header));
+    qint64 written = sizeof(header);
+    for (int c = 0; c < COLUMN_COUNT && ok; ++c) {
+        const qint64 gap = qint64(header.offsets[c]) - written;
+        const qint64 bytes = qint64(tree.size() * ELEMENT_SIZE[c]);
+        ok = file.write(padding, gap) == gap && file.write(columns[c], bytes) == bytes;
+        written = qint64(header.offsets[c]) + bytes;
+    }
+    if (!ok) {
+        file.cancelWriting();
+        return fail(error, file.errorString());
+    }
+    if (!file.commit()) return fail(error, file.errorString());
+    return true;
+}
+
+// ---------------- load ----------------
+bool loadTreeFile(const QString& path, CallTree& tree, TreeFileInfo* info, QString* error) {
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) return fail(error, file->errorString());
+
+    Header header;
+    if (file->read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        std::memcmp(header.magic, TREE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        return fail(error, "Not a call tree file.");
+    }
+    if (header.byteOrder != BYTE_ORDER_MARK) return fail(error, "The file was written with a different byte order.");
+    if (header.version != TREE_FILE_VERSION) {
+        return fail(error, QString("Unsupported tree file version %1 (expected %2).")
+                    .arg(header.version).arg(TREE_FILE_VERSION));
+    }
+    const size_t count = size_t(header.nodeCount);
+    if (count == 0 || header.nodeCount >= NO_NODE) return fail(error, "Bad node count in the tree file.");
+    const quint32 rule = header.flags >> RULE_SHIFT;
+    if (rule >= RuleCount) return fail(error, QString("Unknown recurrence %1 in the tree file.").arg(rule));
+    const quint64 fileSize = quint64(file->size());
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        if (header.offsets[c] % COLUMN_ALIGN != 0 || header.offsets[c] > fileSize ||
+            fileSize - header.offsets[c] < count * ELEMENT_SIZE[c]) {
+            return fail(error, "The tree file is truncated or corrupt.");
+        }
+    }
+
+    // a private (copy-on-write) mapping: columns stay writable like built ones and the file is never modified
+    uchar* base = file->map(0, file->size(), QFileDevice::MapPrivateOption);
+    if (!base) return fail(error, file->errorString());
+
+    CallTree loaded;
+    loaded.n.view(reinterpret_cast<int*>(base + header.offsets[0]), count);
+    loaded.parent.view(reinterpret_cast<NodeId*>(base + header.offsets[1]), count);
+    loaded.firstChild.view(reinterpret_cast<NodeId*>(base + header.offsets[2]), count);
+    loaded.nextSibling.view(reinterpret_cast<NodeId*>(base + header.offsets[3]), count);
+    loaded.depth.view(reinterpret_cast<int*>(base + header.offsets[4]), count);
+    loaded.x.view(reinterpret_cast<double*>(base + header.offsets[5]), count);
+    loaded.y.view(reinterpret_cast<double*>(base + header.offsets[6]), count);
+    loaded.cached.view(reinterpret_cast<std::uint8_t*>(base + header.offsets[7]), count);
+    loaded.storage = file; // unmapped when the last tree viewing it goes away
+    loaded.rule = RecurrenceRule(rule);
+    if (loaded.n[0] != header.rootN || !validColumns(loaded)) return fail(error, "The tree file is truncated or corrupt.");
+    tree = std::move(loaded);
+
+    if (info) {
+        info->rootN = header.rootN;
+        info->memo = (header.flags & FlagMemo) != 0;
+        info->rule = RecurrenceRule(rule);
+        info->nodeCount = count;
+        info->vertGap = header.vertGap;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef TREEFILE_H
+#define TREEFILE_H
+
+#include <QString>
+#include "calltree.h"
+
+// Binary file holding a CallTree and its layout: a fixed header followed by the arena's
+// columns (n, parent, firstChild, nextSibling, depth, x, y, cached), each stored exactly as
+// in memory and 64-byte aligned. Loading maps the file and lets the columns view it, so
+// opening a tree costs no parsing or copying; pages are read as the renderer touches them.
+// Files are written and read in the native (little-endian) byte order.
+
+struct TreeFileInfo {
+    int rootN = 0;
+    bool memo = false;
+    RecurrenceRule rule = RuleFibonacci;
+    size_t nodeCount = 0;
+    double vertGap = 0.0;
+};
+
+static const quint32 TREE_FILE_VERSION = 1;
+
+// Columns are written one after another with plain sequential writes
+bool saveTreeFile(const QString& path, const CallTree& tree, bool memo, double vertGap, QString* error = nullptr);
+// On success tree views the mapped file (tree.storage keeps the mapping alive)
+bool loadTreeFile(const QString& path, CallTree& tree, TreeFileInfo* info = nullptr, QString* error = nullptr);
+
+#endif // TREEFILE_H
@@ -0,0 +1,254 @@
+#include "treepainteritem.h"
+#include "nodeitem.h"
+#include "nodelabels.h"
+#include "profiler.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QLinearGradient>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+// zoom thresholds for the level of detail
+static const double LOD_DOTS = 0.12;   // below: nodes are dots, edges hairlines
+static const double LOD_LABELS = 0.45; // above: full ellipses with labels
+static const int SPRITE_SCALE = 2;     // sprites are rendered at twice the node size
+// trees smaller than this are painted directly at every zoom
+static const size_t TILE_MIN_NODES = 4096;
+// zoom up to which tiles are used; their level scale then stays below LOD_LABELS, so tile
+// renders never draw labels (the shared label cache is GUI-thread only)
+static const double TILE_MAX_LOD = 0.25;
+
+TreePainterItem::TreePainterItem(const CallTree* t, const std::vector<std::uint8_t>* rev,
+                                 const std::vector<NodeHeat>* h, QGraphicsItem* parent)
+    : QGraphicsObject(parent), tree(t), revealed(rev), heat(h) {
+    setFlag(ItemUsesExtendedStyleOption); // gives us exposedRect for culling
+    rows.build(*tree);
+    connect(&tiles, &TileCache::tileReady, this, [this](const QRectF& rect) { update(rect); });
+    if (!tree->empty()) {
+        auto [minX, maxX] = std::minmax_element(tree->x.begin(), tree->x.end());
+        int maxDepth = int(rows.rows.size()) - 1;
+        bounds = QRectF(*minX * H_GAP - NODE_HALF_W, -NODE_HALF_H,
+                        (*maxX - *minX) * H_GAP + 2 * NODE_HALF_W, maxDepth * V_GAP + 2 * NODE_HALF_H);
+    }
+}
+
+// ---------------- shared styles ----------------
+QColor TreePainterItem::heatColor(int level) {
+    // the hue NodeItem::applyHeat gives the middle of the level: blue (short) to red (long)
+    return QColor::fromHsvF(0.66 * (1.0 - (level + 0.5) / HEAT_LEVELS), 0.8, 0.95);
+}
+
+const QBrush& TreePainterItem::brushFor(Style style) {
+    // object-bounding gradients, so one brush fits every node rect
+    static const std::vector<QBrush> brushes = [] {
+        const auto gradient = [](const QColor& from, const QColor& to) {
+            QLinearGradient g(0, 0, 1, 1);
+            g.setCoordinateMode(QGradient::ObjectBoundingMode);
+            g.setColorAt(0.0, from);
+            g.setColorAt(1.0, to);
+            return QBrush(g);
+        };
+        std::vector<QBrush> b = {gradient(QColor(51, 65, 151), QColor(20, 184, 166)),
+                                 gradient(QColor(95, 105, 125), QColor(65, 75, 95)),
+                                 gradient(QColor(255, 94, 98), QColor(255, 159, 67))};
+        for (int level = 0; level < HEAT_LEVELS; ++level) {
+            const QColor fill = heatColor(level);
+            b.push_back(gradient(fill.lighter(115), fill.darker(130)));
+        }
+        return b;
+    }();
+    return brushes[style];
+}
+
+const QPixmap& TreePainterItem::spriteFor(Style style) {
+    static QPixmap sprites[StyleCount];
+    QPixmap &sprite = sprites[style];
+    if (sprite.isNull()) {
+        const QRectF r(0, 0, 2 * NODE_HALF_W * SPRITE_SCALE, 2 * NODE_HALF_H * SPRITE_SCALE);
+        sprite = QPixmap(r.size().toSize());
+        sprite.fill(Qt::transparent);
+        QPainter p(&sprite);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setPen(QPen(QColor(240, 244, 249), SPRITE_SCALE));
+        p.setBrush(brushFor(style));
+        p.drawEllipse(r.adjusted(1, 1, -1, -1));
+    }
+    return sprite;
+}
+
+TreePainterItem::Style TreePainterItem::styleOf(NodeId id, NodeId highlight) const {
+    if (id == highlight) return StyleHighlighted;
+    // as NodeItem: a traced call shows its time, cached or not
+    if (heat && (*heat)[id].exclusive != 0) return Style(StyleHeat + ((*heat)[id].exclusive - 1) * HEAT_LEVELS / 255);
+    return tree->cached[id] ? StyleCached : StyleNormal;
+}
+
+QRectF TreePainterItem::nodeRect(NodeId id) const {
+    return QRectF(tree->x[id] * H_GAP - NODE_HALF_W, tree->y[id] - NODE_HALF_H, 2 * NODE_HALF_W, 2 * NODE_HALF_H);
+}
+
+// ---------------- updates ----------------
+void TreePainterItem::nodeRevealed(NodeId id) {
+    // the node plus the edges to its parent and children
+    QRectF dirty = nodeRect(id);
+    if (tree->parent[id] != NO_NODE) dirty |= nodeRect(tree->parent[id]);
+    for (NodeId c = tree->firstChild[id]; c != NO_NODE; c = tree->nextSibling[c]) dirty |= nodeRect(c);
+    tiles.invalidate(dirty);
+    revealSnapshot.reset();
+    update(dirty);
+}
+
+void TreePainterItem::revealStateChanged() {
+    tiles.clear();
+    revealSnapshot.reset();
+    update();
+}
+
+void TreePainterItem::setHighlighted(NodeId id) {
+    if (highlighted != NO_NODE) {
+        tiles.invalidate(nodeRect(highlighted));
+        update(nodeRect(highlighted));
+    }
+    highlighted = id;
+    if (highlighted != NO_NODE) {
+        tiles.invalidate(nodeRect(highlighted));
+        update(nodeRect(highlighted));
+    }
+}
+
+// ---------------- paint ----------------
+void TreePainterItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*) {
+    // part of the view's "paint view" frame, so not a frame of its own
+    PROFILE_SCOPE("draw batched");
+    QElapsedTimer timer;
+    timer.start();
+
+    const double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int drawn = 0;
+    if (lod > TILE_MAX_LOD || tree->size() < TILE_MIN_NODES) {
+        drawn = drawRegion(painter, option->exposedRect, *revealed, highlighted, true);
+    } else {
+        // zoomed out: blit cached tiles; the pool renders the missing ones from a snapshot
+        if (!revealSnapshot) revealSnapshot = std::make_shared<const std::vector<std::uint8_t>>(*revealed);
+        auto snapshot = revealSnapshot;
+        const NodeId highlight = highlighted;
+        tiles.draw(painter, option->exposedRect, TileCache::levelFor(lod),
+                   [this, snapshot, highlight](QPainter* p, const QRectF& rect) {
+                       drawRegion(p, rect, *snapshot, highlight, false);
+                   },
+                   [&](const QRectF& rect) { drawn = drawRegion(painter, rect, *revealed, highlighted, true); });
+    }
+    emit painted(timer.nsecsElapsed() / 1e6, drawn);
+}
+
+int TreePainterItem::drawRegion(QPainter* painter, const QRectF& area, const std::vector<std::uint8_t>& shown,
+                                NodeId highlight, bool sprites) const {
+    const QTransform wt = painter->worldTransform();
+    const double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(wt);
+    const QRectF exposed = area.adjusted(-NODE_HALF_W, -NODE_HALF_H, NODE_HALF_W, NODE_HALF_H);
+    const double x0 = exposed.left() / H_GAP, x1 = exposed.right() / H_GAP;
+    const auto isShown = [&shown](NodeId id) { return shown[id] != 0; };
+
+    std::vector<QLineF> solidEdges, dashedEdges;
+    std::vector<NodeId> nodes[StyleCount];
+    auto addEdge = [&](NodeId child) {
+        NodeId p = tree->parent[child];
+        if (!isShown(child) || !isShown(p)) return;
+        QLineF line(tree->x[p] * H_GAP, tree->y[p], tree->x[child] * H_GAP, tree->y[child]);
+        (tree->cached[child] ? dashedEdges : solidEdges).push_back(line);
+    };
+
+    // gather the exposed part of the tree: nodes inside, edges crossing
+    int firstRow = -1, lastRow = -1;
+    for (size_t d = 0; d < rows.rows.size(); ++d) {
+        double rowY = tree->y[rows.rows[d].front()];
+        if (rowY + V_GAP < exposed.top() || rowY - V_GAP > exposed.bottom()) continue;
+        if (firstRow < 0) firstRow = int(d);
+        lastRow = int(d);
+    }
+    for (int d = firstRow; d >= 0 && d <= lastRow; ++d) {
+        const auto &row = rows.rows[d];
+        double rowY = tree->y[row.front()];
+        bool rowInView = rowY >= exposed.top() && rowY <= exposed.bottom();
+        auto [first, last] = rows.range(*tree, d, x0, x1);
+        auto inRange = [&](NodeId c) { return tree->depth[c] <= lastRow && tree->x[c] >= x0 && tree->x[c] <= x1; };
+
+        int lastPixel = INT32_MIN;
+        for (size_t i = first; i < last; ++i) {
+            NodeId v = row[i];
+            if (!isShown(v)) continue;
+            // when zoomed out, several nodes share a pixel: draw only the first of each
+            if (lod < LOD_DOTS) {
+                int px = int(std::floor(wt.map(QPointF(tree->x[v] * H_GAP, rowY)).x()));
+                if (px == lastPixel) continue;
+                lastPixel = px;
+            }
+            if (rowInView) nodes[styleOf(v, highlight)].push_back(v);
+            if (tree->parent[v] != NO_NODE) addEdge(v);
+            for (NodeId c = tree->firstChild[v]; c != NO_NODE; c = tree->nextSibling[c]) {
+                if (!inRange(c)) addEdge(c);
+            }
+        }
+        // long edges of the nearest off-range neighbours may cross the exposed area
+        for (size_t i : {first - 1, last}) {
+            if (i >= row.size()) continue; // first - 1 wraps when first == 0
+            for (NodeId c = tree->firstChild[row[i]]; c != NO_NODE; c = tree->nextSibling[c]) {
+                if (!inRange(c)) addEdge(c);
+            }
+        }
+    }
+
+    // edges: two batched calls
+    QPen edgePen(QColor(0, 0, 0), lod < LOD_DOTS ? 0 : 1);
+    painter->setPen(edgePen);
+    painter->drawLines(solidEdges.data(), int(solidEdges.size()));
+    edgePen.setStyle(Qt::DashLine);
+    painter->setPen(edgePen);
+    painter->drawLines(dashedEdges.data(), int(dashedEdges.size()));
+
+    int drawn = 0;
+    for (int s = 0; s < StyleCount; ++s) {
+        const auto &list = nodes[s];
+        drawn += int(list.size());
+        if (list.empty()) continue;
+
+        if (lod < LOD_DOTS) {
+            // one point batch per style, cosmetic pen so dots keep their pixel size
+            std::vector<QPointF> points;
+            points.reserve(list.size());
+            for (NodeId v : list) points.emplace_back(tree->x[v] * H_GAP, tree->y[v]);
+            static const QColor dotColors[StyleHeat] = {
+                QColor(20, 184, 166), QColor(95, 105, 125), QColor(255, 94, 98)
+            };
+            QPen dotPen(s < StyleHeat ? dotColors[s] : heatColor(s - StyleHeat), 4);
+            dotPen.setCosmetic(true);
+            dotPen.setCapStyle(Qt::RoundCap);
+            painter->setPen(dotPen);
+            painter->drawPoints(points.data(), int(points.size()));
+        } else if (lod < LOD_LABELS && sprites) {
+            const QPixmap &sprite = spriteFor(Style(s));
+            for (NodeId v : list) painter->drawPixmap(nodeRect(v), sprite, QRectF(sprite.rect()));
+        } else if (s < StyleHeat) {
+            painter->setPen(QPen(QColor(240, 244, 249), 1));
+            painter->setBrush(brushFor(Style(s)));
+            for (NodeId v : list) painter->drawEllipse(nodeRect(v));
+        } else {
+            // outlined by the time including its calls, as NodeItem::applyHeat
+            painter->setBrush(brushFor(Style(s)));
+            for (NodeId v : list) {
+                const double total = ((*heat)[v].inclusive - 1) / 254.0;
+                painter->setPen(QPen(QColor::fromHsvF(0.66 * (1.0 - total), 0.6, 1.0), 1.0 + 3.0 * total));
+                painter->drawEllipse(nodeRect(v));
+            }
+        }
+    }
+
+    if (lod >= LOD_LABELS) {
+        for (const auto &list : nodes) {
+            for (NodeId v : list) drawNodeLabels(painter, nodeRect(v), tree->rule, tree->n[v]);
+        }
+    }
+
+    return drawn;
+}
@@ -0,0 +1,66 @@
+#ifndef TREEPAINTERITEM_H
+#define TREEPAINTERITEM_H
+
+#include <QGraphicsObject>
+#include <QPixmap>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "calltracer.h"
+#include "calltree.h"
+#include "tilecache.h"
+
+// Single scene item that paints every node and edge of a CallTree in batches.
+// Level of detail follows the zoom: dots and line batches when zoomed out,
+// pre-rendered node sprites in between, gradient ellipses with labels when zoomed in.
+// Zoomed-out views of large trees are blitted from a tile pyramid rendered on a thread pool.
+// Traced trees are colored by measured time as NodeItem does, in HEAT_LEVELS batched shades.
+class TreePainterItem : public QGraphicsObject {
+    Q_OBJECT
+
+public:
+    // revealed[v] != 0 marks nodes that are currently shown; heat colors traced trees
+    TreePainterItem(const CallTree* tree, const std::vector<std::uint8_t>* revealed,
+                    const std::vector<NodeHeat>* heat = nullptr, QGraphicsItem* parent = nullptr);
+
+    QRectF boundingRect() const override { return bounds; }
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+    // schedule a repaint of the area a node and its edges occupy
+    void nodeRevealed(NodeId id);
+    // the reveal state of many nodes changed at once (e.g. reveal all)
+    void revealStateChanged();
+    void setHighlighted(NodeId id);
+
+signals:
+    // paint time of the last frame and how many nodes it drew
+    void painted(double ms, int nodesDrawn);
+
+private:
+    const CallTree* tree;
+    const std::vector<std::uint8_t>* revealed;
+    const std::vector<NodeHeat>* heat;
+    DepthRows rows;
+    QRectF bounds;
+    NodeId highlighted = NO_NODE;
+
+    // shades of measured self time, each drawn as one batch like the other styles
+    static constexpr int HEAT_LEVELS = 16;
+    enum Style { StyleNormal = 0, StyleCached, StyleHighlighted, StyleHeat, StyleCount = StyleHeat + HEAT_LEVELS };
+    // reveal state as seen by tile renders, copied again after reveals
+    std::shared_ptr<const std::vector<std::uint8_t>> revealSnapshot;
+    // declared last: destroyed first, waiting for tile renders that still read the tree
+    TileCache tiles;
+
+    Style styleOf(NodeId id, NodeId highlight) const;
+    QRectF nodeRect(NodeId id) const;
+    // paint the nodes and edges around area; safe on any thread when sprites is false
+    int drawRegion(QPainter* painter, const QRectF& area, const std::vector<std::uint8_t>& shown,
+                   NodeId highlight, bool sprites) const;
+
+    static QColor heatColor(int level);
+    static const QBrush& brushFor(Style style);
+    static const QPixmap& spriteFor(Style style);
+};
+
+#endif // TREEPAINTERITEM_H
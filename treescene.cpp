@@ -0,0 +1,213 @@
+#include "treescene.h"
+#include "memodag.h"
+#include "nodeitem.h"
+#include "profiler.h"
+#include "treepainteritem.h"
+#include "virtualscene.h"
+#include <QElapsedTimer>
+#include <QGraphicsLineItem>
+#include <QGraphicsScene>
+#include <QPen>
+#include <algorithm>
+
+// seeks flipping more nodes than this update the virtualized and batched views in one pass
+static const size_t BULK_REVEAL_CHANGES = 4096;
+
+TreeScene::TreeScene(QGraphicsScene* scene, VirtualTreeScene* virtualScene)
+    : scene(scene), virtualScene(virtualScene) {}
+
+// ---------------- tree ----------------
+void TreeScene::setTree(const CallTree* t, RenderMode m, const std::vector<NodeHeat>* h, const MemoDag* d) {
+    PROFILE_SCOPE("draw tree");
+    clear();
+    tree = t;
+    mode = m;
+    heat = h;
+    dag = d;
+    shown.assign(tree->size(), 0);
+
+    if (mode == RenderVirtualized) {
+        // layout stays in the arena; items are materialized on demand for the viewport
+        virtualScene->setTree(tree, &shown, heat);
+    } else if (mode == RenderBatched) {
+        // one item paints all nodes and edges straight from the arena
+        painter = new TreePainterItem(tree, &shown, heat);
+        scene->addItem(painter);
+        scene->setSceneRect(painter->boundingRect());
+    } else {
+        scene->setSceneRect(QRectF()); // grow with the items again
+        // items are created by populate()
+        nodeItems.assign(tree->size(), nullptr);
+        edges.reserve(tree->size());
+        edgePairs.reserve(tree->size());
+    }
+}
+
+void TreeScene::clear() {
+    virtualScene->reset();
+    scene->clear();
+    scene->setSceneRect(QRectF());
+    tree = nullptr;
+    heat = nullptr;
+    dag = nullptr;
+    painter = nullptr;
+    highlighted = NO_NODE;
+    nodeItems.clear();
+    edges.clear();
+    edgePairs.clear();
+    incidenceOffsets.clear();
+    incidenceEdges.clear();
+    populateNext = 0;
+    reveal.clear();
+    shown.clear();
+    changes.clear();
+}
+
+NodeId TreeScene::edgeCount() const {
+    // one edge into every node but the root, or the DAG's call edges
+    return dag ? NodeId(dag->edges.size()) : NodeId(tree->size());
+}
+
+bool TreeScene::populate(qint64 sliceMs) {
+    if (mode != RenderItems || !tree) return true;
+    PROFILE_SCOPE("populate items");
+    // one node item per tree node, then the edges into each node
+    QElapsedTimer slice;
+    slice.start();
+    const NodeId count = NodeId(tree->size());
+    const NodeId total = count + edgeCount();
+    while (populateNext < total) {
+        if (populateNext < count) {
+            NodeId c = populateNext;
+            NodeItem* it = new NodeItem(c, tree->cached[c]);
+            it->setNode(*tree, c);
+            if (heat) it->setHeat((*heat)[c]);
+            it->setVisible(false);   // start hidden, will reveal one by one
+            it->setScale(0.2);       // small initial scale for a pop-in effect
+            scene->addItem(it);
+            nodeItems[c] = it;
+        } else {
+            // draw edges but hide them initially (preorder: parents are created before children)
+            NodeId p, ch;
+            bool dashed;
+            if (dag) {
+                const MemoDag::Edge &e = dag->edges[populateNext - count];
+                p = e.caller;
+                ch = e.callee;
+                dashed = e.cached;
+            } else {
+                ch = populateNext - count;
+                p = tree->parent[ch];
+                dashed = tree->cached[ch];
+            }
+            if (p != NO_NODE) {
+                QGraphicsLineItem* line = scene->addLine(QLineF(nodeItems[p]->pos(), nodeItems[ch]->pos()));
+                line->setZValue(-1);
+                line->setVisible(false);
+                if (dashed) {
+                    QPen pen = line->pen();
+                    pen.setStyle(Qt::DashLine);
+                    line->setPen(pen);
+                }
+                edges.push_back(line);
+                edgePairs.push_back({p, ch});
+            }
+        }
+        ++populateNext;
+        if (sliceMs >= 0 && (populateNext & 63) == 0 && slice.elapsed() >= sliceMs) break;
+    }
+    if (populateNext < total) return false;
+    if (incidenceOffsets.empty()) buildIncidenceIndex();
+    return true;
+}
+
+int TreeScene::populatePercent() const {
+    if (mode != RenderItems || !tree) return 100;
+    return int(uint64_t(populateNext) * 100 / std::max<NodeId>(1, NodeId(tree->size()) + edgeCount()));
+}
+
+void TreeScene::buildIncidenceIndex() {
+    // counting pass, prefix sum, then fill: O(N + E)
+    incidenceOffsets.assign(tree->size() + 1, 0);
+    for (const auto &e : edgePairs) {
+        ++incidenceOffsets[e.first + 1];
+        ++incidenceOffsets[e.second + 1];
+    }
+    for (size_t v = 0; v < tree->size(); ++v) incidenceOffsets[v + 1] += incidenceOffsets[v];
+
+    incidenceEdges.assign(incidenceOffsets.back(), 0);
+    std::vector<uint32_t> fill(incidenceOffsets.begin(), incidenceOffsets.end() - 1);
+    for (uint32_t i = 0; i < edgePairs.size(); ++i) {
+        incidenceEdges[fill[edgePairs[i].first]++] = i;
+        incidenceEdges[fill[edgePairs[i].second]++] = i;
+    }
+}
+
+QRectF TreeScene::bounds() const {
+    if (mode == RenderVirtualized) return virtualScene->treeBounds();
+    if (mode == RenderBatched) return painter ? painter->boundingRect() : QRectF();
+    return scene->itemsBoundingRect();
+}
+
+NodeItem* TreeScene::itemFor(NodeId node) const {
+    if (mode == RenderVirtualized) return virtualScene->itemFor(node);
+    if (mode == RenderBatched) return nullptr;
+    return node < nodeItems.size() ? nodeItems[node] : nullptr;
+}
+
+void TreeScene::setHighlighted(NodeId node) {
+    if (mode == RenderVirtualized) {
+        virtualScene->setHighlighted(node);
+    } else if (mode == RenderBatched) {
+        if (painter) painter->setHighlighted(node);
+    } else {
+        if (NodeItem* it = itemFor(highlighted)) it->setHighlighted(false);
+        if (NodeItem* it = itemFor(node)) it->setHighlighted(true);
+    }
+    highlighted = node;
+}
+
+// ---------------- reveal ----------------
+void TreeScene::startReveal(RevealSchedule schedule) {
+    reveal.build(*tree, schedule);
+}
+
+const std::vector<NodeId>& TreeScene::seek(size_t step) {
+    reveal.seek(step, &changes);
+    PROFILE_COUNT("reveal changes", int64_t(changes.size()));
+    // long jumps only write the reveal state, then re-query or repaint once
+    const bool bulk = mode != RenderItems && changes.size() > BULK_REVEAL_CHANGES;
+    for (NodeId v : changes) {
+        const bool on = reveal.isVisible(v);
+        if (bulk) shown[v] = on ? 1 : 0;
+        else setRevealed(v, on);
+    }
+    if (bulk && mode == RenderVirtualized) virtualScene->refresh();
+    else if (bulk) painter->revealStateChanged();
+    return changes;
+}
+
+void TreeScene::updateEdgesOf(NodeId node) {
+    // only the edges touching this node can change visibility; an edge shows with both ends
+    for (uint32_t k = incidenceOffsets[node]; k < incidenceOffsets[node + 1]; ++k) {
+        uint32_t e = incidenceEdges[k];
+        NodeId other = edgePairs[e].first == node ? edgePairs[e].second : edgePairs[e].first;
+        edges[e]->setVisible(shown[node] && shown[other]);
+    }
+}
+
+void TreeScene::setRevealed(NodeId node, bool on) {
+    shown[node] = on ? 1 : 0;
+    if (mode == RenderVirtualized) {
+        virtualScene->nodeRevealed(node);
+        return;
+    }
+    if (mode == RenderBatched) {
+        painter->nodeRevealed(node);
+        return;
+    }
+    NodeItem* it = nodeItems[node];
+    it->setVisible(on);
+    it->setScale(1.0);
+    updateEdgesOf(node);
+}
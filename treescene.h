@@ -0,0 +1,93 @@
+#ifndef TREESCENE_H
+#define TREESCENE_H
+
+#include <QRectF>
+#include <QtGlobal>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "calltracer.h"
+#include "calltree.h"
+#include "revealtimeline.h"
+
+class QGraphicsLineItem;
+class QGraphicsScene;
+class NodeItem;
+class TreePainterItem;
+class VirtualTreeScene;
+struct MemoDag;
+
+// How the tree is put on screen (index into comboRenderer)
+enum RenderMode {
+    RenderItems = 0,       // one NodeItem + line per node/edge
+    RenderVirtualized = 1, // pooled items for the viewport only
+    RenderBatched = 2,     // one item painting the whole tree in batches
+    RenderImplicit = 3     // naive tree computed on the fly, never built
+};
+
+// A laid-out CallTree on a QGraphicsScene, drawn by one of the scene renderers (not
+// RenderImplicit, which is a widget of its own), and its reveal along a RevealTimeline.
+// Owns the scene items, the edge incidence index and the reveal state. The window populates
+// it a time slice at a time and seeks it from Step, Skip and the slider; the headless
+// benchmark does the same in one go.
+class TreeScene {
+public:
+    TreeScene(QGraphicsScene* scene, VirtualTreeScene* virtualScene);
+
+    // tree, heat and dag stay owned by the caller and must outlive clear() or the next
+    // setTree(). heat colors traced trees (null: plain); with dag its call edges are drawn
+    // instead of the tree's. Nothing is revealed until startReveal().
+    void setTree(const CallTree* tree, RenderMode mode, const std::vector<NodeHeat>* heat, const MemoDag* dag);
+    // removes every item from the scene
+    void clear();
+    // RenderItems creates its items here, stopping once sliceMs passed (< 0: all of them);
+    // true once every item exists. The other renderers are done right away.
+    bool populate(qint64 sliceMs);
+    int populatePercent() const;
+
+    // a timeline of schedule, at step 0; call with nothing revealed
+    void startReveal(RevealSchedule schedule);
+    // moves the timeline to step and shows or hides what flipped; returns those nodes.
+    // Long jumps write the reveal state and update the virtualized or batched view once.
+    const std::vector<NodeId>& seek(size_t step);
+
+    const RevealTimeline& timeline() const { return reveal; }
+    const std::vector<std::uint8_t>& revealed() const { return shown; }
+    // scene rect of the whole tree, for fitting the view; empty before populate() is done
+    QRectF bounds() const;
+    // nullptr when the node has no item (batched, or virtualized and off screen)
+    NodeItem* itemFor(NodeId node) const;
+    TreePainterItem* painterItem() const { return painter; }
+    // NO_NODE clears the highlight
+    void setHighlighted(NodeId node);
+
+private:
+    QGraphicsScene* scene;
+    VirtualTreeScene* virtualScene;
+    const CallTree* tree = nullptr;
+    const std::vector<NodeHeat>* heat = nullptr;
+    const MemoDag* dag = nullptr;
+    RenderMode mode = RenderItems;
+    TreePainterItem* painter = nullptr;
+    NodeId highlighted = NO_NODE;
+
+    std::vector<NodeItem*> nodeItems; // indexed by NodeId (RenderItems only)
+    std::vector<QGraphicsLineItem*> edges;
+    std::vector<std::pair<NodeId, NodeId>> edgePairs;
+    // per-node incidence index (CSR): edges touching node v are
+    // incidenceEdges[incidenceOffsets[v] .. incidenceOffsets[v+1])
+    std::vector<uint32_t> incidenceOffsets;
+    std::vector<uint32_t> incidenceEdges;
+    NodeId populateNext = 0; // < size: next node item, then size + next edge
+
+    RevealTimeline reveal;
+    std::vector<std::uint8_t> shown;  // reveal state per NodeId, independent of items
+    std::vector<NodeId> changes;      // nodes flipped by the last seek
+
+    NodeId edgeCount() const;
+    void buildIncidenceIndex();
+    void updateEdgesOf(NodeId node);
+    void setRevealed(NodeId node, bool on);
+};
+
+#endif // TREESCENE_H
@@ -0,0 +1,197 @@
+#include "virtualscene.h"
+#include "nodeitem.h"
+#include "profiler.h"
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QGraphicsLineItem>
+#include <QScrollBar>
+#include <QPen>
+#include <algorithm>
+#include <cmath>
+
+// screen spacing below which rows and columns are thinned out, keeping the pool bounded by the viewport size
+static const double MIN_NODE_PX = 14.0;
+
+VirtualTreeScene::VirtualTreeScene(QGraphicsScene* s, QGraphicsView* v, QObject* parent)
+    : QObject(parent), scene(s), view(v) {
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(0);
+    connect(&refreshTimer, &QTimer::timeout, this, &VirtualTreeScene::refresh);
+    connect(view->horizontalScrollBar(), &QScrollBar::valueChanged, this, &VirtualTreeScene::scheduleRefresh);
+    connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &VirtualTreeScene::scheduleRefresh);
+}
+
+void VirtualTreeScene::setTree(const CallTree* t, const std::vector<std::uint8_t>* rev,
+                               const std::vector<NodeHeat>* h) {
+    reset();
+    tree = t;
+    revealed = rev;
+    heat = h;
+    if (!tree || tree->empty()) return;
+
+    rows.build(*tree);
+    int maxDepth = int(rows.rows.size()) - 1;
+    double minX = tree->x[0], maxX = tree->x[0];
+    for (NodeId v = 0; v < tree->size(); ++v) {
+        minX = std::min(minX, tree->x[v]);
+        maxX = std::max(maxX, tree->x[v]);
+    }
+
+    bounds = QRectF(minX * H_GAP - NODE_HALF_W, -NODE_HALF_H,
+                    (maxX - minX) * H_GAP + 2 * NODE_HALF_W, maxDepth * V_GAP + 2 * NODE_HALF_H);
+    scene->setSceneRect(bounds);
+}
+
+void VirtualTreeScene::reset() {
+    refreshTimer.stop();
+    for (auto &kv : boundNodes) delete kv.second;
+    for (auto &kv : boundEdges) delete kv.second;
+    for (NodeItem* it : freeNodes) delete it;
+    for (QGraphicsLineItem* line : freeEdges) delete line;
+    boundNodes.clear();
+    boundEdges.clear();
+    freeNodes.clear();
+    freeEdges.clear();
+    rows.clear();
+    bounds = QRectF();
+    highlighted = NO_NODE;
+    tree = nullptr;
+    revealed = nullptr;
+    heat = nullptr;
+}
+
+NodeItem* VirtualTreeScene::itemFor(NodeId id) const {
+    auto it = boundNodes.find(id);
+    return it == boundNodes.end() ? nullptr : it->second;
+}
+
+void VirtualTreeScene::nodeRevealed(NodeId id) {
+    if (!tree) return;
+    if (NodeItem* it = itemFor(id)) it->setVisible(isRevealed(id));
+
+    auto setEdge = [this](NodeId child) {
+        auto e = boundEdges.find(child);
+        if (e != boundEdges.end()) e->second->setVisible(isRevealed(child) && isRevealed(tree->parent[child]));
+    };
+    if (tree->parent[id] != NO_NODE) setEdge(id);
+    for (NodeId c = tree->firstChild[id]; c != NO_NODE; c = tree->nextSibling[c]) setEdge(c);
+}
+
+void VirtualTreeScene::setHighlighted(NodeId id) {
+    if (NodeItem* it = itemFor(highlighted)) it->setHighlighted(false);
+    highlighted = id;
+    if (NodeItem* it = itemFor(highlighted)) it->setHighlighted(true);
+}
+
+void VirtualTreeScene::scheduleRefresh() {
+    if (tree) refreshTimer.start();
+}
+
+// ---------------- viewport query ----------------
+void VirtualTreeScene::refresh() {
+    PROFILE_SCOPE("virtual refresh");
+    if (!tree || rows.rows.empty()) return;
+
+    QRectF visible = view->mapToScene(view->viewport()->rect()).boundingRect()
+                         .adjusted(-NODE_HALF_W, -NODE_HALF_H, NODE_HALF_W, NODE_HALF_H);
+    size_t maxPerRow = size_t(view->viewport()->width() / MIN_NODE_PX) + 1;
+    // rows closer than MIN_NODE_PX on screen are thinned like columns, so deep trees fitted
+    // to the view bind at most about (width / MIN_NODE_PX) x (height / MIN_NODE_PX) items
+    const double rowPx = V_GAP * std::abs(view->transform().m22());
+    const size_t rowStride = rowPx > 0 ? std::max<size_t>(1, size_t(std::ceil(MIN_NODE_PX / rowPx))) : rows.rows.size();
+
+    std::unordered_map<NodeId, NodeItem*> nextNodes;
+    std::unordered_map<NodeId, QGraphicsLineItem*> nextEdges;
+
+    // rows are sorted by y; rows one level outside the viewport still own edges that cross it
+    const auto &allRows = rows.rows;
+    const size_t dFirst = size_t(std::partition_point(allRows.begin(), allRows.end(), [&](const std::vector<NodeId>& row) {
+        return tree->y[row.front()] + V_GAP < visible.top();
+    }) - allRows.begin());
+    // on a stride grid anchored at row 0, so panning does not change which rows are kept
+    for (size_t d = dFirst - dFirst % rowStride; d < allRows.size(); d += rowStride) {
+        const auto &row = allRows[d];
+        double rowY = tree->y[row.front()];
+        if (rowY - V_GAP > visible.bottom()) break;
+        if (rowY + V_GAP < visible.top()) continue;
+        bool rowInView = rowY >= visible.top() && rowY <= visible.bottom();
+
+        auto [first, last] = rows.range(*tree, int(d), visible.left() / H_GAP, visible.right() / H_GAP);
+        size_t stride = std::max<size_t>(1, (last - first + maxPerRow - 1) / maxPerRow);
+
+        if (rowInView) {
+            for (size_t i = first; i < last; i += stride) bindNode(row[i], nextNodes);
+        }
+
+        // edges of in-range nodes plus the nearest neighbour on each side,
+        // whose long edges may span the viewport without an endpoint inside it
+        auto bindEdgesOf = [&](NodeId v) {
+            if (tree->parent[v] != NO_NODE) bindEdge(v, nextEdges);
+            for (NodeId c = tree->firstChild[v]; c != NO_NODE; c = tree->nextSibling[c]) bindEdge(c, nextEdges);
+        };
+        if (first > 0) bindEdgesOf(row[first - 1]);
+        for (size_t i = first; i < last; i += stride) bindEdgesOf(row[i]);
+        if (last < row.size()) bindEdgesOf(row[last]);
+    }
+
+    // everything that scrolled out goes back to the pool
+    for (auto &kv : boundNodes) {
+        kv.second->setVisible(false);
+        freeNodes.push_back(kv.second);
+    }
+    for (auto &kv : boundEdges) {
+        kv.second->setVisible(false);
+        freeEdges.push_back(kv.second);
+    }
+    boundNodes.swap(nextNodes);
+    boundEdges.swap(nextEdges);
+}
+
+void VirtualTreeScene::bindNode(NodeId id, std::unordered_map<NodeId, NodeItem*>& next) {
+    if (next.count(id)) return;
+    NodeItem* it = nullptr;
+    auto old = boundNodes.find(id);
+    if (old != boundNodes.end()) {
+        it = old->second;
+        boundNodes.erase(old);
+    } else {
+        if (!freeNodes.empty()) {
+            it = freeNodes.back();
+            freeNodes.pop_back();
+        } else {
+            it = new NodeItem(id, tree->cached[id]);
+            scene->addItem(it);
+        }
+        it->setNode(*tree, id);
+        if (heat) it->setHeat((*heat)[id]);
+        it->setScale(1.0);
+        if (id == highlighted) it->setHighlighted(true);
+    }
+    it->setVisible(isRevealed(id));
+    next[id] = it;
+}
+
+void VirtualTreeScene::bindEdge(NodeId child, std::unordered_map<NodeId, QGraphicsLineItem*>& next) {
+    if (next.count(child)) return;
+    NodeId p = tree->parent[child];
+    QGraphicsLineItem* line = nullptr;
+    auto old = boundEdges.find(child);
+    if (old != boundEdges.end()) {
+        line = old->second;
+        boundEdges.erase(old);
+    } else {
+        if (!freeEdges.empty()) {
+            line = freeEdges.back();
+            freeEdges.pop_back();
+        } else {
+            line = scene->addLine(QLineF());
+            line->setZValue(-1);
+        }
+        line->setLine(QLineF(tree->x[p] * H_GAP, tree->y[p], tree->x[child] * H_GAP, tree->y[child]));
+        QPen pen;
+        if (tree->cached[child]) pen.setStyle(Qt::DashLine);
+        line->setPen(pen);
+    }
+    line->setVisible(isRevealed(child) && isRevealed(p));
+    next[child] = line;
+}
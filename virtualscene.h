@@ -0,0 +1,68 @@
+#ifndef VIRTUALSCENE_H
+#define VIRTUALSCENE_H
+
+#include <QObject>
+#include <QRectF>
+#include <QTimer>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "calltree.h"
+#include "calltracer.h"
+
+class QGraphicsScene;
+class QGraphicsView;
+class QGraphicsLineItem;
+class NodeItem;
+
+// Viewport-virtualized presentation of a CallTree.
+// The layout stays in the arena; NodeItems and edge lines are only materialized
+// (from a recycled pool) for nodes that intersect the view's viewport.
+class VirtualTreeScene : public QObject {
+    Q_OBJECT
+
+public:
+    VirtualTreeScene(QGraphicsScene* scene, QGraphicsView* view, QObject* parent = nullptr);
+
+    // revealed[v] != 0 marks nodes that are currently shown; heat colors traced trees
+    void setTree(const CallTree* tree, const std::vector<std::uint8_t>* revealed,
+                 const std::vector<NodeHeat>* heat = nullptr);
+    void reset();
+
+    QRectF treeBounds() const { return bounds; }
+    NodeItem* itemFor(NodeId id) const;   // nullptr when not materialized
+    size_t materializedCount() const { return boundNodes.size(); }
+
+    // re-apply the reveal state of one node (and its edges) to bound items
+    void nodeRevealed(NodeId id);
+    // the highlight follows the node across recycling; NO_NODE clears it
+    void setHighlighted(NodeId id);
+
+public slots:
+    void scheduleRefresh();
+    void refresh();
+
+private:
+    QGraphicsScene* scene;
+    QGraphicsView* view;
+    const CallTree* tree = nullptr;
+    const std::vector<std::uint8_t>* revealed = nullptr;
+    const std::vector<NodeHeat>* heat = nullptr;
+
+    DepthRows rows;
+    QRectF bounds;
+    NodeId highlighted = NO_NODE;
+
+    std::unordered_map<NodeId, NodeItem*> boundNodes;
+    std::unordered_map<NodeId, QGraphicsLineItem*> boundEdges; // keyed by child id
+    std::vector<NodeItem*> freeNodes;
+    std::vector<QGraphicsLineItem*> freeEdges;
+
+    QTimer refreshTimer; // coalesces scroll/zoom notifications
+
+    void bindNode(NodeId id, std::unordered_map<NodeId, NodeItem*>& next);
+    void bindEdge(NodeId child, std::unordered_map<NodeId, QGraphicsLineItem*>& next);
+    bool isRevealed(NodeId id) const { return (*revealed)[id] != 0; }
+};
+
+#endif // VIRTUALSCENE_H